@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <stdio.h>
+#include <time.h>
+
+// Each benchmark times the code between BENCH_START() and BENCH_STOP(), and
+// reports the time per operation for @ops_ operations. BENCH_STOP_BYTES() is
+// the same, but for throughput in bytes.
+#define BENCH(bench_suite, bench_name)                                      \
+    void __BENCH_CASE_NAME(bench_suite, bench_name)(struct bench_result *); \
+    __attribute__((constructor(102)))                                       \
+    void __BENCH_WRAPPER_NAME(bench_suite, bench_name)(void)                \
+    {                                                                       \
+        struct bench_case tmp = {                                           \
+            .func = __BENCH_CASE_NAME(bench_suite, bench_name),             \
+            .suite = #bench_suite,                                          \
+            .name = #bench_name,                                            \
+        };                                                                  \
+        __bench_run(&tmp);                                                  \
+    }                                                                       \
+    void __BENCH_CASE_NAME(bench_suite, bench_name)(struct bench_result *__BENCH_RESULT)
+
+#define BENCH_START() \
+    clock_gettime(CLOCK_MONOTONIC_RAW, &__BENCH_RESULT->start)
+
+#define BENCH_STOP(ops_)                                          \
+    do {                                                          \
+        clock_gettime(CLOCK_MONOTONIC_RAW, &__BENCH_RESULT->end); \
+        __BENCH_RESULT->ops = (ops_);                             \
+        __BENCH_RESULT->unit = "op";                              \
+    } while (0)
+
+#define BENCH_STOP_BYTES(bytes_)                                  \
+    do {                                                          \
+        clock_gettime(CLOCK_MONOTONIC_RAW, &__BENCH_RESULT->end); \
+        __BENCH_RESULT->ops = (bytes_);                           \
+        __BENCH_RESULT->unit = "B";                               \
+    } while (0)
+
+// For benchmarks that need to bail out, e.g. when a sample file is missing
+#define BENCH_FAIL(msg_)                  \
+    do {                                  \
+        __BENCH_RESULT->error = (msg_);   \
+        return;                           \
+    } while (0)
+
+#define __BENCH_RESULT __result
+#define __BENCH_CASE_NAME(suite, name) __bench_case_##suite##_##name
+#define __BENCH_WRAPPER_NAME(suite, name) __bench_wrapper_##suite##_##name
+
+struct bench_result {
+    struct timespec start, end;
+    unsigned long ops;
+    const char *unit;
+    const char *error;
+};
+
+struct bench_case {
+    void (*func)(struct bench_result *);
+    const char *suite;
+    const char *name;
+};
+
+static inline void __bench_run(struct bench_case *bench)
+{
+    struct bench_result result = { 0 };
+    double time;
+
+    bench->func(&result);
+
+    if (result.error) {
+        printf("[ error  ] %s::%s: %s\n", bench->suite, bench->name, result.error);
+        return;
+    }
+
+    time = (result.end.tv_sec - result.start.tv_sec) * 1e9
+        + (result.end.tv_nsec - result.start.tv_nsec);
+
+    printf("[ bench  ] %s::%s: %lu %s in %.3f ms, %.2f ns/%s, %.2f M%s/s\n",
+        bench->suite, bench->name, result.ops, result.unit, time / 1e6,
+        time / result.ops, result.unit, result.ops / time * 1e3, result.unit);
+}
+
+#endif // BENCH_BENCH_H_
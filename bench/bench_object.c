@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <stdio.h>
+
+#include "jsean.h"
+#include "bench.h"
+
+#define KEYS 1000
+#define ROUNDS 1000
+
+static char keys[KEYS][16];
+static jsean key_strs[KEYS];
+static jsean_key key_handles[KEYS];
+
+static void make_object(jsean *obj)
+{
+    jsean val;
+
+    jsean_set_obj(obj);
+    for (int i = 0; i < KEYS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "field_%d", i);
+        jsean_set_str(&key_strs[i], keys[i], 0, NULL);
+        jsean_key_init(&key_handles[i], keys[i], 0);
+
+        jsean_set_num(&val, i);
+        jsean_obj_add(obj, &key_strs[i], &val);
+    }
+}
+
+static double lookup_all(const jsean *obj)
+{
+    double sum = 0.0;
+
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < KEYS; i++)
+            sum += jsean_get_num(jsean_obj_at(obj, &key_strs[i]));
+    }
+
+    return sum;
+}
+
+BENCH(object, obj_at)
+{
+    volatile double sum;
+    jsean obj;
+
+    make_object(&obj);
+
+    BENCH_START();
+    sum = lookup_all(&obj);
+    BENCH_STOP((unsigned long)KEYS * ROUNDS);
+
+    (void)sum;
+    jsean_free(&obj);
+}
+
+BENCH(object, obj_at_frozen)
+{
+    volatile double sum;
+    jsean obj;
+
+    make_object(&obj);
+    if (jsean_freeze(&obj) != JSEAN_SUCCESS)
+        BENCH_FAIL("jsean_freeze() failed");
+
+    BENCH_START();
+    sum = lookup_all(&obj);
+    BENCH_STOP((unsigned long)KEYS * ROUNDS);
+
+    (void)sum;
+    jsean_free(&obj);
+}
+
+BENCH(object, obj_at_key)
+{
+    volatile double sum = 0.0;
+    jsean obj;
+
+    make_object(&obj);
+
+    BENCH_START();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < KEYS; i++)
+            sum += jsean_get_num(jsean_obj_at_key(&obj, &key_handles[i]));
+    }
+    BENCH_STOP((unsigned long)KEYS * ROUNDS);
+
+    jsean_free(&obj);
+}
+
+BENCH(object, obj_get_many_key)
+{
+    volatile double sum = 0.0;
+    jsean obj, *out[KEYS];
+
+    make_object(&obj);
+
+    BENCH_START();
+    for (int r = 0; r < ROUNDS; r++) {
+        jsean_obj_get_many_key(&obj, key_handles, KEYS, out);
+        for (int i = 0; i < KEYS; i++)
+            sum += jsean_get_num(out[i]);
+    }
+    BENCH_STOP((unsigned long)KEYS * ROUNDS);
+
+    jsean_free(&obj);
+}
@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "jsean.h"
+#include "bench.h"
+
+#define ROUNDS 20
+
+// Returns the contents of a sample file, or NULL
+static char *read_sample(const char *path, size_t *len)
+{
+    FILE *fp;
+    char *buf;
+    long size;
+
+    fp = fopen(path, "r");
+    if (!fp)
+        return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    buf = malloc(size + 1);
+    if (buf && fread(buf, 1, size, fp) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+
+    fclose(fp);
+
+    if (buf) {
+        buf[size] = '\0';
+        *len = size;
+    }
+
+    return buf;
+}
+
+static void bench_read(struct bench_result *__BENCH_RESULT, unsigned int flags)
+{
+    jsean src, json;
+    size_t len;
+    char *buf;
+
+    buf = read_sample(SAMPLES_DIR "/1MB.json", &len);
+    if (!buf)
+        BENCH_FAIL("failed to read " SAMPLES_DIR "/1MB.json");
+
+    jsean_set_str(&src, buf, len, free);
+
+    BENCH_START();
+    for (int i = 0; i < ROUNDS; i++) {
+        if (jsean_read_ex(&json, &src, flags) != JSEAN_SUCCESS)
+            BENCH_FAIL("jsean_read_ex() failed");
+        jsean_free(&json);
+    }
+    BENCH_STOP_BYTES((unsigned long)ROUNDS * len);
+
+    jsean_free(&src);
+}
+
+BENCH(read, file_1mb)
+{
+    bench_read(__BENCH_RESULT, 0);
+}
+
+BENCH(read, file_1mb_unique_keys)
+{
+    bench_read(__BENCH_RESULT, JSEAN_READ_UNIQUE_KEYS);
+}
+
+BENCH(read, file_1mb_doc)
+{
+    jsean_doc *doc;
+    jsean src;
+    size_t len;
+    char *buf;
+
+    buf = read_sample(SAMPLES_DIR "/1MB.json", &len);
+    if (!buf)
+        BENCH_FAIL("failed to read " SAMPLES_DIR "/1MB.json");
+
+    jsean_set_str(&src, buf, len, free);
+
+    BENCH_START();
+    for (int i = 0; i < ROUNDS; i++) {
+        if (jsean_read_doc(&doc, &src, 0) != JSEAN_SUCCESS)
+            BENCH_FAIL("jsean_read_doc() failed");
+        jsean_doc_free(doc);
+    }
+    BENCH_STOP_BYTES((unsigned long)ROUNDS * len);
+
+    jsean_free(&src);
+}
+
+#define MESSAGES 200000
+
+static const char *message =
+    "{\"id\": 12345, \"type\": \"trade\", \"symbol\": \"ABCDEF\", "
+    "\"price\": 101.25, \"size\": 300, \"flags\": [\"a\", \"b\"]}";
+
+BENCH(read, small_messages)
+{
+    jsean src, json;
+
+    jsean_set_str(&src, (char *)message, 0, NULL);
+
+    BENCH_START();
+    for (int i = 0; i < MESSAGES; i++) {
+        if (jsean_read(&json, &src) != JSEAN_SUCCESS)
+            BENCH_FAIL("jsean_read() failed");
+        jsean_free(&json);
+    }
+    BENCH_STOP(MESSAGES);
+}
+
+BENCH(read, small_messages_parser)
+{
+    jsean_parser *parser;
+    jsean src, json;
+
+    jsean_set_str(&src, (char *)message, 0, NULL);
+
+    parser = jsean_parser_new(0, NULL);
+    if (!parser)
+        BENCH_FAIL("jsean_parser_new() failed");
+
+    BENCH_START();
+    for (int i = 0; i < MESSAGES; i++) {
+        if (jsean_parser_read(parser, &json, &src) != JSEAN_SUCCESS)
+            BENCH_FAIL("jsean_parser_read() failed");
+        jsean_free(&json);
+    }
+    BENCH_STOP(MESSAGES);
+
+    jsean_parser_free(parser);
+}
+
+BENCH(read, small_messages_pool)
+{
+    jsean_parser *parser;
+    jsean src, json;
+
+    jsean_set_str(&src, (char *)message, 0, NULL);
+
+    parser = jsean_parser_new(0, jsean_pool_allocator());
+    if (!parser)
+        BENCH_FAIL("jsean_parser_new() failed");
+
+    BENCH_START();
+    for (int i = 0; i < MESSAGES; i++) {
+        if (jsean_parser_read(parser, &json, &src) != JSEAN_SUCCESS)
+            BENCH_FAIL("jsean_parser_read() failed");
+        jsean_free(&json);
+    }
+    BENCH_STOP(MESSAGES);
+
+    jsean_parser_free(parser);
+    jsean_pool_trim();
+}
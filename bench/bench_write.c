@@ -0,0 +1,278 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsean.h"
+#include "bench.h"
+
+#define NUMBERS 100000
+#define ROUNDS 10
+
+static void make_numbers(jsean *arr, bool integers)
+{
+    uint64_t state = 0x9e3779b97f4a7c15;
+    jsean val;
+    double num;
+
+    jsean_set_arr(arr);
+    jsean_arr_reserve(arr, NUMBERS);
+
+    for (int i = 0; i < NUMBERS; i++) {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+
+        if (integers)
+            num = (double)((state * 0x2545f4914f6cdd1d) >> 44);
+        else
+            num = (double)((state * 0x2545f4914f6cdd1d) >> 11) / (1 << (i % 20));
+
+        jsean_set_num(&val, num);
+        jsean_arr_push(arr, &val);
+    }
+}
+
+// Writes with one thread per processor if @threads is set
+static void bench_numbers(struct bench_result *__BENCH_RESULT, bool integers,
+    bool threads)
+{
+    jsean arr;
+    char *buf;
+
+    make_numbers(&arr, integers);
+
+    BENCH_START();
+    for (int r = 0; r < ROUNDS; r++) {
+        if (threads)
+            buf = jsean_write_parallel(&arr, NULL, NULL, 0, 0);
+        else
+            buf = jsean_write(&arr, NULL, NULL);
+        if (!buf)
+            BENCH_FAIL("jsean_write() failed");
+        free(buf);
+    }
+    BENCH_STOP((unsigned long)NUMBERS * ROUNDS);
+
+    jsean_free(&arr);
+}
+
+BENCH(write, numbers)
+{
+    bench_numbers(__BENCH_RESULT, false, false);
+}
+
+BENCH(write, integers)
+{
+    bench_numbers(__BENCH_RESULT, true, false);
+}
+
+BENCH(write, numbers_parallel)
+{
+    bench_numbers(__BENCH_RESULT, false, true);
+}
+
+// The same numbers as write::numbers, without building an array first
+BENCH(write, numbers_gen)
+{
+    jsean_gen *gen;
+    jsean arr;
+    char *buf;
+
+    make_numbers(&arr, false);
+
+    BENCH_START();
+    for (int r = 0; r < ROUNDS; r++) {
+        gen = jsean_gen_new(NULL, NULL, NULL, 0);
+        if (!gen)
+            BENCH_FAIL("jsean_gen_new() failed");
+
+        jsean_gen_begin_arr(gen);
+        for (int i = 0; i < NUMBERS; i++)
+            jsean_gen_num(gen, jsean_get_num(jsean_arr_at(&arr, i)));
+        jsean_gen_end(gen);
+
+        if (jsean_gen_finish(gen, &buf, NULL) != JSEAN_SUCCESS)
+            BENCH_FAIL("jsean_gen_finish() failed");
+
+        free(buf);
+        jsean_gen_free(gen);
+    }
+    BENCH_STOP((unsigned long)NUMBERS * ROUNDS);
+
+    jsean_free(&arr);
+}
+
+BENCH(write, file_1mb)
+{
+    jsean json;
+    size_t len;
+    char *buf;
+    FILE *fp;
+
+    fp = fopen(SAMPLES_DIR "/1MB.json", "r");
+    if (!fp)
+        BENCH_FAIL("failed to open " SAMPLES_DIR "/1MB.json");
+
+    if (jsean_read_stream(&json, fp) != JSEAN_SUCCESS)
+        BENCH_FAIL("jsean_read_stream() failed");
+    fclose(fp);
+
+    // The output is about as long as the file
+    buf = jsean_write(&json, &len, NULL);
+    if (!buf)
+        BENCH_FAIL("jsean_write() failed");
+    free(buf);
+
+    BENCH_START();
+    for (int r = 0; r < ROUNDS; r++) {
+        buf = jsean_write(&json, NULL, NULL);
+        if (!buf)
+            BENCH_FAIL("jsean_write() failed");
+        free(buf);
+    }
+    BENCH_STOP_BYTES((unsigned long)ROUNDS * len);
+
+    jsean_free(&json);
+}
+
+static bool discard(void *ctx, const char *data, size_t len)
+{
+    (void)data;
+    *(size_t *)ctx += len;
+    return true;
+}
+
+BENCH(write, file_1mb_stream)
+{
+    size_t len = 0;
+    jsean json;
+    FILE *fp;
+
+    fp = fopen(SAMPLES_DIR "/1MB.json", "r");
+    if (!fp)
+        BENCH_FAIL("failed to open " SAMPLES_DIR "/1MB.json");
+
+    if (jsean_read_stream(&json, fp) != JSEAN_SUCCESS)
+        BENCH_FAIL("jsean_read_stream() failed");
+    fclose(fp);
+
+    BENCH_START();
+    for (int r = 0; r < ROUNDS; r++) {
+        if (jsean_write_cb(&json, discard, &len, NULL) != JSEAN_SUCCESS)
+            BENCH_FAIL("jsean_write_cb() failed");
+    }
+    BENCH_STOP_BYTES((unsigned long)len);
+
+    jsean_free(&json);
+}
+
+#define STRINGS 10000
+
+// Text of a few hundred bytes, with an escape every now and then
+BENCH(write, strings)
+{
+    size_t len = 0;
+    char *str;
+    jsean arr, val;
+    char *buf;
+
+    jsean_set_arr(&arr);
+
+    for (int i = 0; i < STRINGS; i++) {
+        str = malloc(512);
+        if (!str)
+            BENCH_FAIL("out of memory");
+
+        snprintf(str, 512, "Lorem ipsum dolor sit amet, consectetur "
+            "adipiscing elit, sed do eiusmod tempor incididunt ut labore et "
+            "dolore magna aliqua. Ut enim ad minim veniam, quis nostrud "
+            "exercitation ullamco laboris nisi ut aliquip ex ea commodo "
+            "consequat.\n\"Duis aute irure dolor in reprehenderit\" %d", i);
+
+        jsean_set_str(&val, str, 0, free);
+        if (!jsean_arr_push(&arr, &val))
+            BENCH_FAIL("failed to make strings");
+    }
+
+    buf = jsean_write(&arr, &len, NULL);
+    if (!buf)
+        BENCH_FAIL("jsean_write() failed");
+    free(buf);
+
+    BENCH_START();
+    for (int r = 0; r < ROUNDS; r++) {
+        buf = jsean_write(&arr, NULL, NULL);
+        if (!buf)
+            BENCH_FAIL("jsean_write() failed");
+        free(buf);
+    }
+    BENCH_STOP_BYTES((unsigned long)ROUNDS * len);
+
+    jsean_free(&arr);
+}
+
+#define BLOBS 64
+#define BLOB_SIZE (64 * 1024)
+
+// Long strings with nothing to escape, like base64, copied or pointed to
+static void bench_blobs(struct bench_result *__BENCH_RESULT, bool iov)
+{
+    jsean_iov *list;
+    jsean arr, val;
+    size_t len;
+    char *str;
+
+    jsean_set_arr(&arr);
+
+    for (int i = 0; i < BLOBS; i++) {
+        str = malloc(BLOB_SIZE + 1);
+        if (!str)
+            BENCH_FAIL("out of memory");
+
+        for (int j = 0; j < BLOB_SIZE; j++)
+            str[j] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[(i + j) % 64];
+        str[BLOB_SIZE] = '\0';
+
+        jsean_set_str(&val, str, BLOB_SIZE, free);
+        if (!jsean_arr_push(&arr, &val))
+            BENCH_FAIL("out of memory");
+    }
+
+    len = jsean_write_size(&arr, NULL);
+
+    BENCH_START();
+    for (int r = 0; r < ROUNDS; r++) {
+        if (iov) {
+            list = jsean_write_iov(&arr, NULL, 0);
+            if (!list)
+                BENCH_FAIL("jsean_write_iov() failed");
+            jsean_iov_free(list);
+        } else {
+            str = jsean_write(&arr, NULL, NULL);
+            if (!str)
+                BENCH_FAIL("jsean_write() failed");
+            free(str);
+        }
+    }
+    BENCH_STOP_BYTES((unsigned long)ROUNDS * len);
+
+    jsean_free(&arr);
+}
+
+BENCH(write, blobs)
+{
+    bench_blobs(__BENCH_RESULT, false);
+}
+
+BENCH(write, blobs_iov)
+{
+    bench_blobs(__BENCH_RESULT, true);
+}
@@ -0,0 +1,5 @@
+// Benchmarks are run by their constructors, before main()
+int main(void)
+{
+    return 0;
+}
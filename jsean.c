@@ -22,12 +22,48 @@ static const char *__status_strings[] = {
 #undef X
 };
 
-unsigned int get_internal_type(const jsean *json)
+static void *heap_alloc(void *ctx, size_t size)
 {
-    if (!json || json->type >= __INTERNAL_TYPE_COUNT)
-        return INTERNAL_TYPE_UNKNOWN;
+    (void)ctx;
+    return malloc(size);
+}
 
-    return json->type;
+static void *heap_realloc(void *ctx, void *ptr, size_t old_size, size_t size)
+{
+    (void)ctx;
+    (void)old_size;
+    return realloc(ptr, size);
+}
+
+static void heap_free(void *ctx, void *ptr, size_t size)
+{
+    (void)ctx;
+    (void)size;
+    free(ptr);
+}
+
+const jsean_allocator heap_allocator = {
+    .alloc = heap_alloc,
+    .realloc = heap_realloc,
+    .free = heap_free,
+    .ctx = NULL,
+};
+
+static const jsean_allocator *__default_allocator = &heap_allocator;
+
+void jsean_set_allocator(const jsean_allocator *alloc)
+{
+    __default_allocator = alloc ? alloc : &heap_allocator;
+}
+
+const jsean_allocator *jsean_get_allocator(void)
+{
+    return __default_allocator;
+}
+
+const jsean_allocator *default_allocator(void)
+{
+    return __default_allocator;
 }
 
 unsigned int jsean_get_type(const jsean *json)
@@ -66,6 +102,7 @@ void jsean_free(jsean *json)
         break;
 
     case JSEAN_TYPE_STRING:
+    case JSEAN_TYPE_RAW:
         str_free(json);
         break;
 
@@ -74,13 +111,45 @@ void jsean_free(jsean *json)
     }
 }
 
-bool strbuf_init(struct strbuf *buf)
+int jsean_freeze(jsean *json)
+{
+    switch (jsean_get_type(json)) {
+    case JSEAN_TYPE_OBJECT:
+        return obj_freeze(json) ? JSEAN_SUCCESS : JSEAN_OUT_OF_MEMORY;
+
+    case JSEAN_TYPE_ARRAY:
+        return arr_freeze(json) ? JSEAN_SUCCESS : JSEAN_OUT_OF_MEMORY;
+
+    case JSEAN_TYPE_UNKNOWN:
+        return JSEAN_INVALID_ARGUMENTS;
+
+    default:
+        return JSEAN_SUCCESS;
+    }
+}
+
+bool jsean_is_frozen(const jsean *json)
+{
+    switch (jsean_get_type(json)) {
+    case JSEAN_TYPE_OBJECT:
+        return json->ao_ptr && ((struct obj *)json->ao_ptr)->frozen;
+
+    case JSEAN_TYPE_ARRAY:
+        return json->ao_ptr && ((struct arr *)json->ao_ptr)->frozen;
+
+    default:
+        return false;
+    }
+}
+
+bool strbuf_init(struct strbuf *buf, const jsean_allocator *alloc)
 {
     char *data;
 
+    buf->alloc = alloc;
     buf->cap = STRBUF_DEFAULT_CAPACITY;
 
-    data = malloc(sizeof(*data) * buf->cap);
+    data = mem_alloc(alloc, sizeof(*data) * buf->cap);
     if (!data)
         return false;
 
@@ -93,7 +162,29 @@ bool strbuf_init(struct strbuf *buf)
 void strbuf_free(struct strbuf *buf)
 {
     if (buf && buf->data)
-        free(buf->data);
+        mem_free(buf->alloc, buf->data, buf->cap);
+}
+
+bool strbuf_reserve(struct strbuf *buf, size_t n)
+{
+    char *data;
+    size_t cap;
+
+    if (buf->cap - buf->len >= n)
+        return true;
+
+    cap = next_capacity(buf->cap);
+    while (cap - buf->len < n)
+        cap = next_capacity(cap);
+
+    data = mem_realloc(buf->alloc, buf->data, buf->cap, sizeof(*data) * cap);
+    if (!data)
+        return false;
+
+    buf->data = data;
+    buf->cap = cap;
+
+    return true;
 }
 
 // Assumes both @buf and @byte are valid
@@ -105,7 +196,7 @@ bool strbuf_add_byte(struct strbuf *buf, char byte)
     if (buf->len >= buf->cap) {
         cap = next_capacity(buf->cap);
 
-        data = realloc(buf->data, sizeof(*data) * cap);
+        data = mem_realloc(buf->alloc, buf->data, buf->cap, sizeof(*data) * cap);
         if (!data)
             return false;
 
@@ -128,7 +219,7 @@ bool strbuf_add_bytes(struct strbuf *buf, const char *bytes, size_t len)
         while (buf->len + len >= cap)
             cap = next_capacity(cap);
 
-        data = realloc(buf->data, sizeof(*data) * cap);
+        data = mem_realloc(buf->alloc, buf->data, buf->cap, sizeof(*data) * cap);
         if (!data)
             return false;
 
@@ -152,7 +243,7 @@ bool strbuf_add_codepoint(struct strbuf *buf, int cp)
         while (buf->len + 4 >= cap)
             cap = next_capacity(cap);
 
-        data = realloc(buf->data, sizeof(*data) * cap);
+        data = mem_realloc(buf->alloc, buf->data, buf->cap, sizeof(*data) * cap);
         if (!data)
             return false;
 
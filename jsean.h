@@ -23,18 +23,34 @@
                 (c_str);                                                 \
             }),                                                          \
             .s_len = sizeof(c_str) - 1,                                  \
-            .s_free_fn = NULL,                                           \
             .type = JSEAN_TYPE_STRING,                                   \
         }                                                                \
     })
 
+// Create a precomputed key from a string literal. With optimizations enabled,
+// the hash is computed at compile time.
+#define JSEAN_K(c_str)                                                   \
+    ((jsean_key[]){                                                      \
+        {                                                                \
+            .k_val = ({                                                  \
+                _Static_assert(                                          \
+                    __builtin_types_compatible_p(typeof(c_str), char[]), \
+                    "argument must be a string literal");                \
+                (c_str);                                                 \
+            }),                                                          \
+            .k_len = sizeof(c_str) - 1,                                  \
+            .k_hash = __jsean_hash((c_str), sizeof(c_str) - 1),          \
+        }                                                                \
+    })
+
 #define __JSEAN_TYPE_LIST(X) \
     X(JSEAN_TYPE_NULL, "null") \
     X(JSEAN_TYPE_BOOLEAN, "boolean") \
     X(JSEAN_TYPE_OBJECT, "object") \
     X(JSEAN_TYPE_ARRAY, "array") \
     X(JSEAN_TYPE_NUMBER, "number") \
-    X(JSEAN_TYPE_STRING, "string")
+    X(JSEAN_TYPE_STRING, "string") \
+    X(JSEAN_TYPE_RAW, "raw")
 
 enum jsean_type {
 #define X(type_, str_) type_,
@@ -59,11 +75,16 @@ enum jsean_type {
     X(JSEAN_EXPECTED_TRUE, "expected 'true'")                                                 \
     X(JSEAN_EXPECTED_VALUE, "expected 'false', 'null', 'true', '{', '[', '-', '\"' or digit") \
     X(JSEAN_EXPECTED_WHITESPACE, "unexpected non-whitespace character")                       \
+    X(JSEAN_FROZEN, "value is frozen")                                                        \
     X(JSEAN_INVALID_ARGUMENTS, "invalid arguments")                                           \
     X(JSEAN_INVALID_ESCAPE_SEQUENCE, "invalid escape sequence")                               \
+    X(JSEAN_INVALID_NESTING, "value not allowed here")                                        \
     X(JSEAN_INVALID_UNICODE_ESCAPE_SEQUENCE, "invalid Unicode escape sequence")               \
     X(JSEAN_INVALID_UTF8_SEQUENCE, "invalid UTF-8 sequence")                                  \
-    X(JSEAN_OUT_OF_MEMORY, "out of memory")
+    X(JSEAN_OUT_OF_MEMORY, "out of memory")                                                   \
+    X(JSEAN_TOO_MANY_ALLOCATORS, "too many distinct allocators")                              \
+    X(JSEAN_TOO_MANY_FREE_FUNCTIONS, "too many distinct free functions")                      \
+    X(JSEAN_WRITE_FAILED, "failed to write output")
 
 enum jsean_status {
 #define X(status_, str_) status_,
@@ -73,27 +94,95 @@ enum jsean_status {
     __JSEAN_STATUS_COUNT,
 };
 
-typedef struct {
-    union {
-        // Bool
-        bool b_val;
+typedef union {
+    struct {
+        union {
+            // Bool
+            bool b_val;
 
-        // Array, object
-        void *ao_ptr;
+            // Array, object
+            void *ao_ptr;
 
-        // Number
-        double n_val;
+            // Number
+            double n_val;
 
-        // String
-        struct {
+            // String
             char *s_val;
-            unsigned int s_len;
-            void (*s_free_fn)(void *);
         };
+        unsigned int s_len;
+        unsigned int type : 8;
+
+        // Index of the string's free function in a shared table, or zero if
+        // the string is not freed. Keeps the value at 16 bytes.
+        unsigned int s_free : 8;
+        unsigned int s_small : 1;
+        unsigned int s_small_len : 4;
+
+        // Set once the string's bytes have been looked at, see
+        // jsean_str_flags()
+        unsigned int s_known : 1;
+        unsigned int s_escape : 1;
+        unsigned int s_ascii : 1;
     };
-    unsigned int type;
+
+    // Short strings are stored in the value itself, if @s_small is set
+    char s_buf[12];
 } jsean;
 
+// A key with a precomputed hash, for looking up the same key repeatedly. The
+// string is not copied.
+typedef struct {
+    const char *k_val;
+    unsigned int k_len;
+    size_t k_hash;
+} jsean_key;
+
+// Custom memory allocation for arrays, objects and strings. Sizes are always
+// passed back, so an allocator does not need to remember them. Reallocating
+// or freeing NULL must work.
+typedef struct {
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t size);
+    void (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} jsean_allocator;
+
+// Hashes the string with djb2, http://www.cse.yorku.ca/~oz/hash.html
+static inline size_t __jsean_hash(const char *str, size_t len)
+{
+    size_t hash;
+
+    // Unrolled, so that hashes of short literals fold into constants
+    hash = 638130537;
+#pragma GCC unroll 32
+    for (size_t i = 0; i < len; i++)
+        hash = ((hash << 5) + hash) + str[i];
+
+    // Zero is reserved for undefined hashes
+    if (hash == 0)
+        hash++;
+
+    return hash;
+}
+
+// Set the allocator for new arrays and objects, strings read from JSON,
+// documents and the parser's scratch memory, or NULL for malloc(). It must
+// outlive every value allocated with it, and should be set before other
+// threads use the library.
+void jsean_set_allocator(const jsean_allocator *alloc);
+const jsean_allocator *jsean_get_allocator(void);
+
+// An allocator that keeps freed blocks of up to 4 KiB for reuse, instead of
+// giving them back to malloc(). Each thread has its own free blocks, and
+// hands off some of them to the other threads when it has too many.
+//
+// jsean_pool_flush() hands off all of the calling thread's blocks, and
+// should be called before the thread exits, or they are leaked.
+// jsean_pool_trim() frees the calling thread's blocks and those handed off.
+const jsean_allocator *jsean_pool_allocator(void);
+void jsean_pool_flush(void);
+void jsean_pool_trim(void);
+
 // Get the type of a JSON value.
 unsigned int jsean_get_type(const jsean *json);
 
@@ -103,11 +192,165 @@ const char *jsean_status_to_str(int status);
 // Free a JSON value
 void jsean_free(jsean *json);
 
+// Make a JSON value and everything in it immutable. Objects are rebuilt with a
+// perfect hash, so that looking up a key takes a single probe. Functions that
+// would modify a frozen array or object return JSEAN_FROZEN. The older ones
+// without a status return NULL, like when out of memory, or do nothing, so
+// check jsean_is_frozen() first where the difference matters.
+int jsean_freeze(jsean *json);
+bool jsean_is_frozen(const jsean *json);
+
+enum jsean_read_flags {
+    // Trust that no object has duplicate keys, and skip checking for them.
+    // If there are duplicates anyway, which value is found is unspecified.
+    JSEAN_READ_UNIQUE_KEYS = 1 << 0,
+
+    // Store every non-empty array of only numbers packed, as with
+    // jsean_arr_pack()
+    JSEAN_READ_PACK_NUMBERS = 1 << 1,
+};
+
 // Read and write JSON data
 int jsean_read(jsean *json, jsean *src);
 int jsean_read_stream(jsean *json, FILE *fp);
+int jsean_read_ex(jsean *json, jsean *src, unsigned int flags);
+int jsean_read_stream_ex(jsean *json, FILE *fp, unsigned int flags);
+
+// Same as jsean_read_ex() and jsean_read_stream_ex(), but the values are
+// allocated with @alloc, instead of the default allocator. Strings remember
+// their allocator, and at most 128 different allocators can be used for them
+// for the lifetime of the program, besides the default one and documents.
+// Reading with another one gives JSEAN_TOO_MANY_ALLOCATORS.
+int jsean_read_alloc(jsean *json, jsean *src, unsigned int flags, const jsean_allocator *alloc);
+int jsean_read_stream_alloc(jsean *json, FILE *fp, unsigned int flags, const jsean_allocator *alloc);
+
+// A parser that can be reused for reading many texts. It keeps its scratch
+// memory between reads, at the size it has grown to, so reading small texts
+// does not allocate anything but the values. A parser must only be used by
+// one thread at a time.
+//
+// Values are allocated with @alloc, or with the default allocator at the
+// time of reading if NULL. jsean_parser_reset() changes the flags and the
+// allocator, and keeps the scratch memory.
+typedef struct jsean_parser jsean_parser;
+
+jsean_parser *jsean_parser_new(unsigned int flags, const jsean_allocator *alloc);
+void jsean_parser_reset(jsean_parser *parser, unsigned int flags, const jsean_allocator *alloc);
+void jsean_parser_free(jsean_parser *parser);
+int jsean_parser_read(jsean_parser *parser, jsean *json, jsean *src);
+int jsean_parser_read_stream(jsean_parser *parser, jsean *json, FILE *fp);
+
+enum jsean_write_flags {
+    // Escape every non-ASCII character as \uXXXX, or as a surrogate pair
+    // above U+FFFF. Invalid UTF-8 is written as U+FFFD.
+    JSEAN_WRITE_ASCII = 1 << 0,
+};
 
+// The returned string is allocated with malloc().
 char *jsean_write(const jsean *json, size_t *len, const char *indent);
+char *jsean_write_ex(const jsean *json, size_t *len, const char *indent, unsigned int flags);
+
+// Same as jsean_write_ex(), but the elements or members of a large top-level
+// array or object are split between up to @threads threads, or as many as
+// there are processors if 0. The text is the same as jsean_write_ex() writes.
+// The values must not be modified until it returns.
+//
+// The threads are started and joined on every call, so values with fewer
+// than 2048 elements or members are written on the calling thread alone.
+// The pieces written by the threads are joined into the first one, freeing
+// each as it is copied, so the memory used peaks at about the size of the
+// output.
+char *jsean_write_parallel(const jsean *json, size_t *len, const char *indent, unsigned int flags, unsigned int threads);
+
+// Returns the exact length of the output of jsean_write_ex(), without the
+// null terminator, or 0 if @json is NULL.
+size_t jsean_write_size(const jsean *json, const char *indent);
+size_t jsean_write_size_ex(const jsean *json, const char *indent, unsigned int flags);
+
+// Writes into @buf, without a null terminator, and without allocating any
+// memory. Returns the length of the output, or 0 if it doesn't fit in @cap
+// bytes, in which case the contents of @buf are unspecified.
+size_t jsean_write_to(const jsean *json, char *buf, size_t cap, const char *indent);
+size_t jsean_write_to_ex(const jsean *json, char *buf, size_t cap, const char *indent, unsigned int flags);
+
+// Receives the output of jsean_write_cb() a piece at a time. Returns false
+// if the output couldn't be written, which stops writing.
+typedef bool (*jsean_sink)(void *ctx, const char *data, size_t len);
+
+// Writes the output in pieces, through a buffer of fixed size, so the memory
+// used doesn't grow with the output. Returns JSEAN_WRITE_FAILED if the sink or
+// the file fails, after which some of the output may have been written.
+int jsean_write_stream(const jsean *json, FILE *fp, const char *indent);
+int jsean_write_stream_ex(const jsean *json, FILE *fp, const char *indent, unsigned int flags);
+int jsean_write_cb(const jsean *json, jsean_sink sink, void *ctx, const char *indent);
+int jsean_write_cb_ex(const jsean *json, jsean_sink sink, void *ctx, const char *indent, unsigned int flags);
+
+// Writes into a list of pieces for writev() and sendmsg(). Syntax and short
+// text are copied into buffers owned by the list, and long runs of string
+// text with nothing to escape, and raw values, are pointed to where they are.
+// The values must not be modified or freed while the list is used. The list
+// may have more than IOV_MAX pieces. struct iovec comes from <sys/uio.h>,
+// which is left for the caller to include.
+typedef struct jsean_iov jsean_iov;
+struct iovec;
+
+jsean_iov *jsean_write_iov(const jsean *json, const char *indent, unsigned int flags);
+void jsean_iov_free(jsean_iov *iov);
+const struct iovec *jsean_iov_vec(const jsean_iov *iov, size_t *count);
+
+// Returns the length of the text in all pieces
+size_t jsean_iov_len(const jsean_iov *iov);
+
+// Writes JSON text a value at a time, without building the values first.
+// Output goes to @sink through a buffer of fixed size, or into memory if
+// @sink is NULL. @indent and @flags are as for jsean_write_ex(), and the text
+// is the same as jsean_write_ex() would write for the same values.
+//
+// Calls that would make the text invalid, like a value in an object without
+// a key, return JSEAN_INVALID_NESTING and write nothing. Once writing fails,
+// every call returns the same error. Strings must be null-terminated if
+// length is zero.
+typedef struct jsean_gen jsean_gen;
+
+jsean_gen *jsean_gen_new(jsean_sink sink, void *ctx, const char *indent, unsigned int flags);
+void jsean_gen_free(jsean_gen *gen);
+int jsean_gen_begin_obj(jsean_gen *gen);
+int jsean_gen_begin_arr(jsean_gen *gen);
+int jsean_gen_end(jsean_gen *gen);
+int jsean_gen_key(jsean_gen *gen, const char *str, size_t len);
+int jsean_gen_null(jsean_gen *gen);
+int jsean_gen_bool(jsean_gen *gen, bool b);
+int jsean_gen_num(jsean_gen *gen, double num);
+int jsean_gen_str(jsean_gen *gen, const char *str, size_t len);
+
+// Writes a whole value, and everything in it
+int jsean_gen_value(jsean_gen *gen, const jsean *json);
+
+// Checks that the top-level value is complete, and flushes the output to the
+// sink. Without a sink, the text is returned in @out, null-terminated and
+// allocated with malloc(), and its length in @len. After this, the generator
+// can only be freed.
+int jsean_gen_finish(jsean_gen *gen, char **out, size_t *len);
+
+// A document owns a value read from JSON text, and everything in it. Its
+// arrays, objects and strings are allocated from an arena, and freeing the
+// document releases the arena at once, without visiting the values.
+//
+// The values can be modified as usual, and values added to the document's
+// arrays and objects are freed with it. Values that own memory must not be
+// stored into the document through pointers, such as the one returned by
+// jsean_doc_root(), or they are leaked. Values taken out of the document are
+// valid until it is freed.
+//
+// The arena gets its memory from the default allocator. Values allocated with
+// jsean_doc_allocator() are freed with the document as well.
+typedef struct jsean_doc jsean_doc;
+
+int jsean_read_doc(jsean_doc **doc, jsean *src, unsigned int flags);
+int jsean_read_doc_stream(jsean_doc **doc, FILE *fp, unsigned int flags);
+jsean *jsean_doc_root(jsean_doc *doc);
+const jsean_allocator *jsean_doc_allocator(jsean_doc *doc);
+void jsean_doc_free(jsean_doc *doc);
 
 int jsean_set_null(jsean *json);
 
@@ -119,30 +362,106 @@ int jsean_set_obj(jsean *json);
 size_t jsean_obj_len(const jsean *json);
 jsean *jsean_obj_at(const jsean *json, const jsean *key);
 
-// Does not copy the value or the key. The key must be unique.
+// Does not copy the value. The key must be unique. It is taken over by the
+// object and set to null, and its string may be freed right away, so it must
+// not be used again. A key without a freeing function may be kept as it is,
+// and must outlive the object. Returns NULL, leaving the key alone, if the
+// key is in use or the object is frozen.
 jsean *jsean_obj_add(jsean *json, jsean *key, jsean *val);
 
-// Does not copy the value or the key. The key may already be in use. If the
-// provided key is used, it is set to null.
+// Does not copy the value. The key may already be in use. It is taken over by
+// the object, or freed if it was already in use, and then set to null, as
+// with jsean_obj_add(). Returns NULL if the object is frozen.
 jsean *jsean_obj_set(jsean *json, jsean *key, jsean *val);
+
+// Returns the value for the key, inserting a null value if the key is not in
+// use, so that the value can be set in place. Finds the slot with a single
+// probe. The key is taken over by the object, or freed if it was already in
+// use, and then set to null. @found may be NULL. Returns NULL if the object is
+// frozen, even if the key is in use.
+jsean *jsean_obj_entry(jsean *json, jsean *key, bool *found);
+
+// Does nothing if the object is frozen.
 void jsean_obj_del(jsean *json, const jsean *key);
+
+// String must be null-terminated if length is zero.
+int jsean_key_init(jsean_key *key, const char *str, size_t len);
+
+// Same as jsean_obj_at() and jsean_obj_set(), but without hashing the key. The
+// key string is not copied, and must outlive the object.
+jsean *jsean_obj_at_key(const jsean *json, const jsean_key *key);
+jsean *jsean_obj_set_key(jsean *json, const jsean_key *key, jsean *val);
+
+// Look up @n keys at once, storing the values, or NULL for missing keys, in
+// @out. Returns the number of keys found. Faster than separate lookups on
+// large objects, as the memory accesses overlap.
+size_t jsean_obj_get_many(const jsean *json, const jsean *keys, size_t n, jsean **out);
+size_t jsean_obj_get_many_key(const jsean *json, const jsean_key *keys, size_t n, jsean **out);
+
+// Does nothing if the object is frozen.
 void jsean_obj_clear(jsean *json);
 
+// Make room for at least @n members in total, so that adding them doesn't
+// grow the table.
+int jsean_obj_reserve(jsean *json, size_t n);
+
+// Rebuild the table without the slots left behind by deleted members, and
+// shrink it to fit the remaining members.
+int jsean_obj_compact(jsean *json);
+
 // Lazily allocated
 int jsean_set_arr(jsean *json);
 size_t jsean_arr_len(const jsean *json);
+
+// Returns NULL if the array is packed, see jsean_arr_pack().
 jsean *jsean_arr_at(const jsean *json, const size_t index);
 
 // Does not copy the value. Shifts values to make space for the new value. If
-// the index is the element after last, the value is appended.
+// the index is the element after last, the value is appended. Returns NULL if
+// the array is frozen.
 jsean *jsean_arr_add(jsean *json, const size_t index, const jsean *val);
 
 // Does not copy the value. The value at the given index is overwritten. If the
 // index is the element after last (i.e. length), the value is appended.
+// Returns NULL if the array is frozen.
 jsean *jsean_arr_set(jsean *json, const size_t index, const jsean *val);
+
+// Does nothing if the array is frozen. jsean_arr_del_range() returns
+// JSEAN_FROZEN instead.
 void jsean_arr_del(jsean *json, const size_t index);
+
+// Does not copy the values. Removes @del_count values from the index, and
+// inserts @n values in their place, with at most one reallocation and one
+// move of the following values.
+int jsean_arr_splice(jsean *json, size_t index, size_t del_count, const jsean *vals, size_t n);
+
+// Does not copy the values. Appends @n values.
+int jsean_arr_extend(jsean *json, const jsean *vals, size_t n);
+int jsean_arr_del_range(jsean *json, size_t index, size_t count);
+
+// Does nothing if the array is frozen.
 void jsean_arr_clear(jsean *json);
 
+// Make room for at least @n values in total, so that adding them doesn't
+// reallocate.
+int jsean_arr_reserve(jsean *json, size_t n);
+int jsean_arr_shrink_to_fit(jsean *json);
+
+// Stores an array of numbers as a contiguous double[], as the parser does
+// with JSEAN_READ_PACK_NUMBERS. The numbers are read with jsean_arr_num() or
+// jsean_arr_num_data(), and jsean_arr_at() returns NULL for them. Adding a
+// value, or jsean_arr_unpack(), unpacks the array again, which moves it. In a
+// document, the old block stays in the arena until the document is freed.
+int jsean_arr_pack(jsean *json);
+int jsean_arr_unpack(jsean *json);
+
+// Returns the numbers of a packed array, or NULL if the array is not packed.
+double *jsean_arr_num_data(jsean *json, size_t *len);
+
+// Returns the number at @index, or 0 if it isn't a number. Packed arrays are
+// read as they are, without unpacking them.
+double jsean_arr_num(const jsean *json, size_t index);
+
 static inline jsean *jsean_arr_push(jsean *json, const jsean *val)
 {
     return jsean_arr_add(json, jsean_arr_len(json), val);
@@ -158,9 +477,42 @@ int jsean_set_num(jsean *json, double num);
 double jsean_get_num(const jsean *json);
 
 // String must be null-terminated if length is zero. The freeing function may
-// be NULL if the string doesn't need to be freed.
+// be NULL if the string doesn't need to be freed. Freeing functions other than
+// free() are kept in a table shared by all strings and raw values, which has
+// room for 126 of them for the lifetime of the program. Once it is full, a
+// new function gives JSEAN_TOO_MANY_FREE_FUNCTIONS.
 int jsean_set_str(jsean *json, char *str, size_t len, void (*free_fn)(void *));
+
+// Short strings read by the parser are stored in the value itself, so the
+// pointer is valid only for as long as the value is not moved, for example by
+// adding values to the array or the object it is in.
 const char *jsean_get_str(const jsean *json);
 size_t jsean_str_len(const jsean *json);
 
+enum jsean_str_flags {
+    // Has bytes that are escaped on output
+    JSEAN_STR_ESCAPE = 1 << 0,
+
+    // Has no bytes above 0x7f
+    JSEAN_STR_ASCII = 1 << 1,
+};
+
+// Returns what is known about the string's bytes, from enum jsean_str_flags.
+// Strings read from JSON know it from the start, and others are scanned the
+// first time they are asked. The writer skips scanning strings that need no
+// escaping.
+unsigned int jsean_str_flags(jsean *json);
+
+// Raw JSON text, which is written as it is, for splicing in text that was
+// written before. The text is stored and freed like a string, and must be
+// null-terminated if length is zero. jsean_set_raw() trusts that the text is
+// valid JSON, and jsean_set_raw_checked() reads it through once to make sure,
+// without building any values, and returns the error from reading if it
+// isn't. The freeing function is limited in the same way as for
+// jsean_set_str().
+int jsean_set_raw(jsean *json, char *str, size_t len, void (*free_fn)(void *));
+int jsean_set_raw_checked(jsean *json, char *str, size_t len, void (*free_fn)(void *));
+const char *jsean_get_raw(const jsean *json);
+size_t jsean_raw_len(const jsean *json);
+
 #endif // JSEAN_H
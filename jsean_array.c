@@ -4,6 +4,8 @@
 // Licensed under the BSD 2-Clause License. See LICENSE.txt
 //
 
+#include <limits.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,22 +13,128 @@
 #include "jsean.h"
 #include "jsean_internal.h"
 
-static struct arr *arr_init(void)
+// Size of the block for an array of @cap values
+static inline size_t arr_size(size_t cap, bool packed)
+{
+    return sizeof(struct arr) + (packed ? sizeof(double) : sizeof(jsean)) * cap;
+}
+
+static struct arr *arr_init(const jsean_allocator *alloc, size_t cap)
 {
     struct arr *arr;
-    jsean *ptr;
 
-    arr = malloc(sizeof(*arr));
+    arr = mem_alloc(alloc, arr_size(cap, false));
     if (!arr)
         return NULL;
 
-    arr->cap = ARRAY_DEFAULT_CAPACITY;
+    arr->alloc = alloc;
+    arr->cap = cap;
     arr->len = 0;
+    arr->frozen = false;
+    arr->packed = false;
+
+    return arr;
+}
+
+static inline size_t arr_grow(size_t cap)
+{
+    return cap ? next_capacity(cap) : ARRAY_DEFAULT_CAPACITY;
+}
+
+// Resizes the array's block for @cap values, or for doubles if @packed is
+// set. The array may move. Returns NULL if out of memory, leaving the array
+// as it was.
+static struct arr *arr_realloc(jsean *json, size_t cap, bool packed)
+{
+    struct arr *arr = json->ao_ptr;
+
+    arr = mem_realloc(arr->alloc, arr, arr_size(arr->cap, arr->packed),
+        arr_size(cap, packed));
+    if (!arr)
+        return NULL;
+
+    arr->cap = cap;
+    json->ao_ptr = arr;
+
+    return arr;
+}
+
+static inline struct arr *arr_resize(jsean *json, size_t cap)
+{
+    return arr_realloc(json, cap, ((struct arr *)json->ao_ptr)->packed);
+}
+
+bool arr_create(jsean *json, const jsean_allocator *alloc)
+{
+    if (!json->ao_ptr)
+        json->ao_ptr = arr_init(alloc, 0);
+
+    return json->ao_ptr != NULL;
+}
+
+// Each double is written at or before the value it came from, so the values
+// can be converted in place, front to back
+static void values_to_nums(jsean *ptr, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        ((double *)ptr)[i] = ptr[i].n_val;
+}
+
+// The reverse of values_to_nums(), back to front. Each value is cleared
+// first, so no bytes of the doubles are left in its other fields.
+static void nums_to_values(jsean *ptr, size_t len)
+{
+    double num;
+
+    for (size_t i = len; i-- > 0;) {
+        num = ((double *)ptr)[i];
+        memset(&ptr[i], 0, sizeof(ptr[i]));
+        ptr[i].type = JSEAN_TYPE_NUMBER;
+        ptr[i].n_val = num;
+    }
+}
+
+bool arr_pack(jsean *json)
+{
+    struct arr *arr = json->ao_ptr;
+
+    if (arr->packed)
+        return true;
+
+    if (arr->frozen)
+        return false;
+
+    for (size_t i = 0; i < arr->len; i++) {
+        if (arr->vals[i].type != JSEAN_TYPE_NUMBER)
+            return false;
+    }
+
+    values_to_nums(arr->vals, arr->len);
+
+    if (arr->cap && (arr = arr_realloc(json, arr->cap, true)) == NULL) {
+        arr = json->ao_ptr;
+        nums_to_values(arr->vals, arr->len);
+        return false;
+    }
+
+    arr->packed = true;
 
-    ptr = malloc(sizeof(*ptr) * arr->cap);
-    if (!ptr)
+    return true;
+}
+
+// Returns the array, which may have moved, or NULL if out of memory
+static struct arr *arr_unpack(jsean *json)
+{
+    struct arr *arr = json->ao_ptr;
+
+    if (!arr->packed)
+        return arr;
+
+    if (arr->cap && (arr = arr_realloc(json, arr->cap, false)) == NULL)
         return NULL;
-    arr->ptr = ptr;
+
+    nums_to_values(arr->vals, arr->len);
+    arr->packed = false;
 
     return arr;
 }
@@ -70,7 +178,12 @@ jsean *jsean_arr_at(const jsean *json, const size_t index)
     if (index >= arr->len)
         return NULL;
 
-    return &arr->ptr[index];
+    // Packed arrays have no values to point to, and unpacking would move
+    // the array, which a reader must not do
+    if (arr->packed)
+        return NULL;
+
+    return (jsean *)&arr->vals[index];
 }
 
 jsean *jsean_arr_set(jsean *json, const size_t index, const jsean *val)
@@ -83,78 +196,141 @@ jsean *jsean_arr_set(jsean *json, const size_t index, const jsean *val)
     if (jsean_get_type(val) == JSEAN_TYPE_UNKNOWN)
         return NULL;
 
-    if (!json->ao_ptr && (json->ao_ptr = arr_init()) == NULL)
+    if (!json->ao_ptr && (json->ao_ptr = arr_init(default_allocator(), ARRAY_DEFAULT_CAPACITY)) == NULL)
         return NULL;
 
     arr = json->ao_ptr;
 
-    if (index > arr->len)
+    if (index > arr->len || arr->frozen || (arr = arr_unpack(json)) == NULL)
         return NULL;
 
     if (arr->len == index)
         return jsean_arr_add(json, index, val);
 
-    memcpy(&arr->ptr[index], val, sizeof(*val));
-    return &arr->ptr[index];
+    mem_adopt(arr->alloc, val);
+    memcpy(&arr->vals[index], val, sizeof(*val));
+    return &arr->vals[index];
 }
 
 jsean *jsean_arr_add(jsean *json, const size_t index, const jsean *val)
 {
     struct arr *arr;
-    jsean *data;
-    size_t cap, len;
+    size_t len;
 
     if (!json || json->type != JSEAN_TYPE_ARRAY || !val)
         return NULL;
 
-    if (!json->ao_ptr && (json->ao_ptr = arr_init()) == NULL)
+    if (!json->ao_ptr && (json->ao_ptr = arr_init(default_allocator(), ARRAY_DEFAULT_CAPACITY)) == NULL)
         return NULL;
 
     arr = json->ao_ptr;
 
-    if (index > arr->len)
+    if (index > arr->len || arr->frozen || (arr = arr_unpack(json)) == NULL)
         return NULL;
 
-    if (arr->len == arr->cap) {
-        cap = next_capacity(arr->cap);
-
-        data = realloc(arr->ptr, sizeof(*data) * cap);
-        if (!data)
-            return NULL;
-
-        arr->ptr = data;
-        arr->cap = cap;
-    }
+    if (arr->len == arr->cap && (arr = arr_resize(json, arr_grow(arr->cap))) == NULL)
+        return NULL;
 
     if (index != arr->len) {
         len = sizeof(*val) * (arr->len - index);
-        memmove(&arr->ptr[index + 1], &arr->ptr[index], len);
+        memmove(&arr->vals[index + 1], &arr->vals[index], len);
     }
 
-    memcpy(&arr->ptr[index], val, sizeof(*val));
+    mem_adopt(arr->alloc, val);
+    memcpy(&arr->vals[index], val, sizeof(*val));
     arr->len++;
-    return &arr->ptr[index];
+    return &arr->vals[index];
 }
 
 void jsean_arr_del(jsean *json, const size_t index)
+{
+    jsean_arr_del_range(json, index, 1);
+}
+
+int jsean_arr_splice(jsean *json, size_t index, size_t del_count,
+    const jsean *vals, size_t n)
 {
     struct arr *arr;
-    size_t len;
+    size_t len, cap;
 
-    if (!json || json->type != JSEAN_TYPE_ARRAY || !json->ao_ptr)
-        return;
+    if (jsean_get_type(json) != JSEAN_TYPE_ARRAY || (n && !vals))
+        return JSEAN_INVALID_ARGUMENTS;
+
+    for (size_t i = 0; i < n; i++) {
+        if (jsean_get_type(&vals[i]) == JSEAN_TYPE_UNKNOWN)
+            return JSEAN_INVALID_ARGUMENTS;
+    }
+
+    if (!json->ao_ptr) {
+        if (index || del_count)
+            return JSEAN_INVALID_ARGUMENTS;
+
+        if (!n)
+            return JSEAN_SUCCESS;
+
+        json->ao_ptr = arr_init(default_allocator(), n > ARRAY_DEFAULT_CAPACITY ? n : ARRAY_DEFAULT_CAPACITY);
+        if (!json->ao_ptr)
+            return JSEAN_OUT_OF_MEMORY;
+    }
 
     arr = json->ao_ptr;
-    if (!arr->ptr || index >= arr->len)
-        return;
+    if (arr->frozen)
+        return JSEAN_FROZEN;
+
+    if (index > arr->len || del_count > arr->len - index)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    len = arr->len - del_count + n;
+    if (len > UINT_MAX)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    // Deleting from a packed array keeps it packed
+    if (n && (arr = arr_unpack(json)) == NULL)
+        return JSEAN_OUT_OF_MEMORY;
+
+    if (len > arr->cap) {
+        cap = arr_grow(arr->cap);
+        while (cap < len)
+            cap = next_capacity(cap);
 
-    if (index != arr->len - 1) {
-        len = sizeof(*arr->ptr) * (arr->len - index - 1);
-        memmove(&arr->ptr[index], &arr->ptr[index + 1], len);
+        if ((arr = arr_resize(json, cap)) == NULL)
+            return JSEAN_OUT_OF_MEMORY;
     }
 
-    jsean_free(&arr->ptr[index]);
-    arr->len--;
+    if (arr->packed) {
+        memmove(&arr_nums(arr)[index], &arr_nums(arr)[index + del_count],
+            sizeof(double) * (arr->len - index - del_count));
+        arr->len = len;
+
+        return JSEAN_SUCCESS;
+    }
+
+    for (size_t i = index; i < index + del_count; i++)
+        jsean_free(&arr->vals[i]);
+
+    if (del_count != n) {
+        memmove(&arr->vals[index + n], &arr->vals[index + del_count],
+            sizeof(*arr->vals) * (arr->len - index - del_count));
+    }
+
+    for (size_t i = 0; i < n; i++)
+        mem_adopt(arr->alloc, &vals[i]);
+
+    if (n)
+        memcpy(&arr->vals[index], vals, sizeof(*vals) * n);
+    arr->len = len;
+
+    return JSEAN_SUCCESS;
+}
+
+int jsean_arr_extend(jsean *json, const jsean *vals, size_t n)
+{
+    return jsean_arr_splice(json, jsean_arr_len(json), 0, vals, n);
+}
+
+int jsean_arr_del_range(jsean *json, size_t index, size_t count)
+{
+    return jsean_arr_splice(json, index, count, NULL, 0);
 }
 
 void jsean_arr_clear(jsean *json)
@@ -166,25 +342,166 @@ void jsean_arr_clear(jsean *json)
         return;
 
     arr = json->ao_ptr;
-    if (!arr->len)
+    if (!arr->len || arr->frozen)
+        return;
+
+    if (arr->packed) {
+        arr->len = 0;
         return;
+    }
 
-    for (tmp = &arr->ptr[0], last = &arr->ptr[arr->len]; tmp != last; tmp++)
+    for (tmp = &arr->vals[0], last = &arr->vals[arr->len]; tmp != last; tmp++)
         jsean_free(tmp);
     arr->len = 0;
 }
 
+int jsean_arr_reserve(jsean *json, size_t n)
+{
+    struct arr *arr;
+
+    if (jsean_get_type(json) != JSEAN_TYPE_ARRAY || n > UINT_MAX)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (!json->ao_ptr) {
+        json->ao_ptr = arr_init(default_allocator(), n > ARRAY_DEFAULT_CAPACITY ? n : ARRAY_DEFAULT_CAPACITY);
+        return json->ao_ptr ? JSEAN_SUCCESS : JSEAN_OUT_OF_MEMORY;
+    }
+
+    arr = json->ao_ptr;
+    if (arr->frozen)
+        return JSEAN_FROZEN;
+
+    if (n <= arr->cap)
+        return JSEAN_SUCCESS;
+
+    return arr_resize(json, n) ? JSEAN_SUCCESS : JSEAN_OUT_OF_MEMORY;
+}
+
+int jsean_arr_shrink_to_fit(jsean *json)
+{
+    struct arr *arr;
+
+    if (jsean_get_type(json) != JSEAN_TYPE_ARRAY)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    arr = json->ao_ptr;
+    if (!arr)
+        return JSEAN_SUCCESS;
+
+    if (arr->frozen)
+        return JSEAN_FROZEN;
+
+    // Keep room for one value, so the array can still grow
+    if (arr->cap == arr->len || arr->cap == 1)
+        return JSEAN_SUCCESS;
+
+    return arr_resize(json, arr->len ? arr->len : 1) ? JSEAN_SUCCESS : JSEAN_OUT_OF_MEMORY;
+}
+
+int jsean_arr_unpack(jsean *json)
+{
+    if (jsean_get_type(json) != JSEAN_TYPE_ARRAY)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (!json->ao_ptr)
+        return JSEAN_SUCCESS;
+
+    return arr_unpack(json) ? JSEAN_SUCCESS : JSEAN_OUT_OF_MEMORY;
+}
+
+int jsean_arr_pack(jsean *json)
+{
+    struct arr *arr;
+
+    if (jsean_get_type(json) != JSEAN_TYPE_ARRAY)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    arr = json->ao_ptr;
+    if (!arr)
+        return JSEAN_SUCCESS;
+
+    if (arr->frozen)
+        return JSEAN_FROZEN;
+
+    return arr_pack(json) ? JSEAN_SUCCESS : JSEAN_INVALID_ARGUMENTS;
+}
+
+double jsean_arr_num(const jsean *json, size_t index)
+{
+    const struct arr *arr;
+
+    if (jsean_get_type(json) != JSEAN_TYPE_ARRAY)
+        return 0.0;
+
+    arr = json->ao_ptr;
+    if (!arr || index >= arr->len)
+        return 0.0;
+
+    if (arr->packed)
+        return arr_nums(arr)[index];
+
+    return jsean_get_num(&arr->vals[index]);
+}
+
+double *jsean_arr_num_data(jsean *json, size_t *len)
+{
+    struct arr *arr;
+
+    if (jsean_get_type(json) != JSEAN_TYPE_ARRAY)
+        return NULL;
+
+    arr = json->ao_ptr;
+    if (!arr || !arr->packed)
+        return NULL;
+
+    if (len)
+        *len = arr->len;
+
+    return arr_nums(arr);
+}
+
 void arr_free(jsean *json)
 {
     struct arr *arr = json->ao_ptr;
     jsean *tmp, *last;
 
-    if (!arr || !arr->ptr)
+    if (!arr)
         return;
 
-    for (tmp = &arr->ptr[0], last = &arr->ptr[arr->len]; tmp != last; tmp++)
-        jsean_free(tmp);
+    if (!arr->packed) {
+        for (tmp = &arr->vals[0], last = &arr->vals[arr->len]; tmp != last; tmp++)
+            jsean_free(tmp);
+    }
+
+    mem_free(arr->alloc, arr, arr_size(arr->cap, arr->packed));
+}
+
+bool arr_freeze(jsean *json)
+{
+    struct arr *arr = json->ao_ptr;
+    jsean *tmp, *last;
+
+    if (!arr) {
+        if (!arr_create(json, default_allocator()))
+            return false;
+
+        ((struct arr *)json->ao_ptr)->frozen = true;
+        return true;
+    }
+
+    if (arr->frozen)
+        return true;
+
+    // Frozen values may be shared between threads, so they cannot be
+    // unpacked lazily
+    if ((arr = arr_unpack(json)) == NULL)
+        return false;
+
+    for (tmp = &arr->vals[0], last = &arr->vals[arr->len]; tmp != last; tmp++) {
+        if (jsean_freeze(tmp) != JSEAN_SUCCESS)
+            return false;
+    }
 
-    free(arr->ptr);
-    free(arr);
+    arr->frozen = true;
+    return true;
 }
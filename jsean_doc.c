@@ -0,0 +1,290 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsean.h"
+#include "jsean_internal.h"
+
+#define ALIGN_UP(n) (((n) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+struct chunk {
+    struct chunk *next;
+    size_t size;
+    size_t used;
+    _Alignas(max_align_t) char data[];
+};
+
+// Allocates by bumping a pointer in the newest chunk. Memory is only given
+// back when the whole arena is freed, except for the latest allocation, which
+// can also grow and shrink in place.
+//
+// If @foreign is set, a value with memory of its own was added to the
+// document, so its values have to be visited before the chunks are freed.
+// Chunks themselves come from @backing, the default allocator at the time
+// the arena was made.
+struct arena {
+    const jsean_allocator *backing;
+    struct chunk *head;
+    char *last;
+    size_t next_size;
+    bool foreign;
+    jsean_allocator alloc;
+};
+
+struct jsean_doc {
+    jsean root;
+    struct arena arena;
+};
+
+static struct chunk *chunk_new(const jsean_allocator *backing, size_t size)
+{
+    struct chunk *chunk;
+
+    chunk = mem_alloc(backing, sizeof(*chunk) + size);
+    if (!chunk)
+        return NULL;
+
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+
+    return chunk;
+}
+
+static void *arena_alloc(void *ctx, size_t size)
+{
+    struct arena *arena = ctx;
+    struct chunk *chunk;
+
+    size = ALIGN_UP(size);
+
+    chunk = arena->head;
+    if (chunk->size - chunk->used < size) {
+        chunk = chunk_new(arena->backing,
+            size > arena->next_size ? size : arena->next_size);
+        if (!chunk)
+            return NULL;
+
+        chunk->next = arena->head;
+        arena->head = chunk;
+
+        if (arena->next_size < ARENA_CHUNK_SIZE_MAX)
+            arena->next_size *= 2;
+    }
+
+    arena->last = &chunk->data[chunk->used];
+    chunk->used += size;
+
+    return arena->last;
+}
+
+static void *arena_realloc(void *ctx, void *ptr, size_t old_size, size_t size)
+{
+    struct arena *arena = ctx;
+    struct chunk *chunk = arena->head;
+    size_t offset;
+    void *tmp;
+
+    if (!ptr)
+        return arena_alloc(ctx, size);
+
+    // The latest allocation can be resized in place, if it still fits
+    if (ptr == arena->last) {
+        offset = arena->last - chunk->data;
+
+        if (chunk->size - offset >= ALIGN_UP(size)) {
+            chunk->used = offset + ALIGN_UP(size);
+            return ptr;
+        }
+    }
+
+    if (size <= old_size)
+        return ptr;
+
+    tmp = arena_alloc(ctx, size);
+    if (!tmp)
+        return NULL;
+
+    memcpy(tmp, ptr, old_size);
+
+    return tmp;
+}
+
+static void arena_free(void *ctx, void *ptr, size_t size)
+{
+    struct arena *arena = ctx;
+
+    (void)size;
+
+    if (ptr && ptr == arena->last) {
+        arena->head->used = arena->last - arena->head->data;
+        arena->last = NULL;
+    }
+}
+
+bool is_arena(const jsean_allocator *alloc)
+{
+    return alloc->alloc == arena_alloc;
+}
+
+void arena_adopt(const jsean_allocator *alloc, const jsean *val)
+{
+    struct arena *arena;
+    const struct arr *arr;
+    const struct obj *obj;
+
+    if (!is_arena(alloc))
+        return;
+
+    arena = alloc->ctx;
+    if (arena->foreign)
+        return;
+
+    switch (jsean_get_type(val)) {
+    case JSEAN_TYPE_NULL:
+    case JSEAN_TYPE_BOOLEAN:
+    case JSEAN_TYPE_NUMBER:
+        return;
+
+    case JSEAN_TYPE_STRING:
+    case JSEAN_TYPE_RAW:
+        if (val->s_small || val->s_free == STRING_FREE_NONE)
+            return;
+        break;
+
+    case JSEAN_TYPE_ARRAY:
+        arr = val->ao_ptr;
+        if (arr && arr->alloc == alloc)
+            return;
+        break;
+
+    case JSEAN_TYPE_OBJECT:
+        obj = val->ao_ptr;
+        if (obj && obj->alloc == alloc)
+            return;
+        break;
+
+    default:
+        break;
+    }
+
+    arena->foreign = true;
+}
+
+static jsean_doc *doc_new(size_t size_hint)
+{
+    const jsean_allocator *backing = default_allocator();
+    struct chunk *chunk;
+    jsean_doc *doc;
+    size_t size;
+
+    size = ALIGN_UP(sizeof(*doc)) + size_hint;
+    if (size < ARENA_CHUNK_SIZE)
+        size = ARENA_CHUNK_SIZE;
+
+    chunk = chunk_new(backing, size);
+    if (!chunk)
+        return NULL;
+
+    // The document itself lives at the start of the first chunk
+    doc = (jsean_doc *)chunk->data;
+    chunk->used = ALIGN_UP(sizeof(*doc));
+
+    jsean_set_null(&doc->root);
+    doc->arena.backing = backing;
+    doc->arena.head = chunk;
+    doc->arena.last = NULL;
+    doc->arena.next_size = size < ARENA_CHUNK_SIZE_MAX ? size : ARENA_CHUNK_SIZE_MAX;
+    doc->arena.foreign = false;
+    doc->arena.alloc.alloc = arena_alloc;
+    doc->arena.alloc.realloc = arena_realloc;
+    doc->arena.alloc.free = arena_free;
+    doc->arena.alloc.ctx = &doc->arena;
+
+    return doc;
+}
+
+int jsean_read_doc(jsean_doc **doc, jsean *src, unsigned int flags)
+{
+    jsean_doc *tmp;
+    int ret;
+
+    if (!doc || jsean_get_type(src) != JSEAN_TYPE_STRING)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    // Values take about as much memory as the text they are read from
+    tmp = doc_new(jsean_str_len(src));
+    if (!tmp)
+        return JSEAN_OUT_OF_MEMORY;
+
+    ret = read_buffer_with(&tmp->root, jsean_get_str(src), jsean_str_len(src),
+        flags, &tmp->arena.alloc);
+    if (ret != JSEAN_SUCCESS) {
+        jsean_doc_free(tmp);
+        return ret;
+    }
+
+    *doc = tmp;
+    return JSEAN_SUCCESS;
+}
+
+int jsean_read_doc_stream(jsean_doc **doc, FILE *fp, unsigned int flags)
+{
+    jsean_doc *tmp;
+    int ret;
+
+    if (!doc || !fp)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    tmp = doc_new(0);
+    if (!tmp)
+        return JSEAN_OUT_OF_MEMORY;
+
+    ret = read_stream_with(&tmp->root, fp, flags, &tmp->arena.alloc);
+    if (ret != JSEAN_SUCCESS) {
+        jsean_doc_free(tmp);
+        return ret;
+    }
+
+    *doc = tmp;
+    return JSEAN_SUCCESS;
+}
+
+jsean *jsean_doc_root(jsean_doc *doc)
+{
+    return doc ? &doc->root : NULL;
+}
+
+const jsean_allocator *jsean_doc_allocator(jsean_doc *doc)
+{
+    return doc ? &doc->arena.alloc : NULL;
+}
+
+void jsean_doc_free(jsean_doc *doc)
+{
+    const jsean_allocator *backing;
+    struct chunk *chunk, *next;
+
+    if (!doc)
+        return;
+
+    // Freeing values from the arena does nothing, so this only frees what
+    // was added from elsewhere
+    if (doc->arena.foreign)
+        jsean_free(&doc->root);
+
+    // The document is in the last chunk, so it goes last
+    backing = doc->arena.backing;
+    for (chunk = doc->arena.head; chunk; chunk = next) {
+        next = chunk->next;
+        mem_free(backing, chunk, sizeof(*chunk) + chunk->size);
+    }
+}
@@ -7,57 +7,169 @@
 #ifndef JSEAN_INTERNAL_H
 #define JSEAN_INTERNAL_H
 
+#include <limits.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "jsean.h"
 
 #define STRING_LENGTH_MAX           4294967294 // 2^32-1
 #define STRING_HASH_UNDEFINED       0
 
+// Indexes in the table of free functions. Other functions are added to the
+// table when they are first used. Strings from an allocator have the index of
+// the allocator, plus STRING_FREE_ALLOC.
+#define STRING_FREE_NONE            0
+#define STRING_FREE_DEFAULT         1 // free()
+#define STRING_FREE_ALLOC           128
+#define STRING_FREE_MAX             256
+
+// Longest string stored in the value itself, leaving room for a null
+// terminator
+#define STRING_SMALL_MAX            (sizeof(((jsean *)0)->s_buf) - 1)
+
+#define KEY_HASH_MASK               0x3fffffff
+#define KEY_DEAD                    UINT_MAX
+
+// Longest key stored in the slot itself
+#define KEY_SMALL_MAX               sizeof(char *)
+
 #define ARRAY_DEFAULT_CAPACITY      8
 
 #define OBJECT_DEFAULT_CAPACITY     16
 #define OBJECT_LOAD_FACTOR_MAX      0.67
 
+// How many keys are hashed and prefetched at once, for batched lookups
+#define OBJECT_BATCH_SIZE           16
+
+// Average number of keys per bucket in a frozen object's perfect hash, and
+// how many seeds to try for a bucket before giving up
+#define PHF_BUCKET_SIZE             4
+#define PHF_SEED_MAX                (1 << 20)
+#define PHF_SLOT                    0x80000000
+
 #define STRBUF_DEFAULT_CAPACITY     16
 
-enum internal_type {
-    // Same as jsean_type
-    INTERNAL_TYPE_NULL,
-    INTERNAL_TYPE_BOOLEAN,
-    INTERNAL_TYPE_OBJECT,
-    INTERNAL_TYPE_ARRAY,
-    INTERNAL_TYPE_NUMBER,
-    INTERNAL_TYPE_STRING,
+// Size of a document's first chunk, unless the input suggests a larger one,
+// and the size that chunks stop doubling at
+#define ARENA_CHUNK_SIZE            4096
+#define ARENA_CHUNK_SIZE_MAX        (1 << 22)
+#define ARENA_ALIGNMENT             _Alignof(max_align_t)
 
-    // For object internals
-    INTERNAL_TYPE_EMPTY,
-    INTERNAL_TYPE_DEAD,
+// Block sizes of the pool allocator, in powers of two, and how many free
+// blocks of a size a thread keeps before handing half of them off
+#define POOL_CLASS_SHIFT            5
+#define POOL_CLASS_MIN              (1 << POOL_CLASS_SHIFT)
+#define POOL_CLASS_MAX              4096
+#define POOL_CLASS_COUNT            8
+#define POOL_CACHE_MAX              256
 
-    __INTERNAL_TYPE_COUNT,
+// Uses malloc(), realloc() and free()
+extern const jsean_allocator heap_allocator;
 
-    INTERNAL_TYPE_UNKNOWN,
-};
+// Returns the default allocator
+const jsean_allocator *default_allocator(void);
+
+static inline void *mem_alloc(const jsean_allocator *alloc, size_t size)
+{
+    return alloc->alloc(alloc->ctx, size);
+}
+
+static inline void *mem_realloc(const jsean_allocator *alloc, void *ptr,
+    size_t old_size, size_t size)
+{
+    return alloc->realloc(alloc->ctx, ptr, old_size, size);
+}
+
+static inline void mem_free(const jsean_allocator *alloc, void *ptr, size_t size)
+{
+    alloc->free(alloc->ctx, ptr, size);
+}
+
+// Called when a value is added to an array or an object that uses @alloc. If
+// @alloc is a document's arena, and the value has memory of its own, the
+// document has to visit its values when it is freed.
+void arena_adopt(const jsean_allocator *alloc, const jsean *val);
+bool is_arena(const jsean_allocator *alloc);
 
+static inline void mem_adopt(const jsean_allocator *alloc, const jsean *val)
+{
+    if (alloc != &heap_allocator)
+        arena_adopt(alloc, val);
+}
+
+// The values follow the header in the same block, so the whole array moves
+// when it grows. If @packed is set, the array holds only numbers, and they
+// are stored as plain doubles, see arr_nums(). The array is unpacked when a
+// value is added, and by jsean_arr_unpack(), but never by a reader.
 struct arr {
-    jsean *ptr;
+    const jsean_allocator *alloc;
     unsigned int cap;
     unsigned int len;
+    bool frozen;
+    bool packed;
+    jsean vals[];
+};
+
+static inline double *arr_nums(const struct arr *arr)
+{
+    return (double *)arr->vals;
+}
+
+// Keys are kept apart from the values, so that probing only touches keys. A
+// slot is empty if @ptr is NULL and @small is not set, or dead if @len is also
+// KEY_DEAD. @hash has the low bits of the key's hash. Keys of up to
+// KEY_SMALL_MAX bytes are stored in @buf, and owned keys are freed with the
+// object's allocator.
+struct obj_key {
+    union {
+        char *ptr;
+        char buf[KEY_SMALL_MAX];
+    };
+    unsigned int len;
+    unsigned int hash : 30;
+    unsigned int owned : 1;
+    unsigned int small : 1;
 };
 
+// The table follows the header in the same block, @keys first and then the
+// values, so slot i of the table is @keys[i] and obj_vals()[i]. The object
+// moves to a new block when the table is rebuilt.
+//
+// If @disp is set, the object is frozen and the table holds exactly @len
+// pairs, placed by a minimal perfect hash. Each bucket in @disp, which is at
+// the end of the block, holds either a seed for the bucket's keys, or a slot
+// (marked with PHF_SLOT) for single keys.
 struct obj {
-    struct obj_pair *ptr;
+    const jsean_allocator *alloc;
+    unsigned int *disp;
     unsigned int cap;
     unsigned int len;
     unsigned int dead;
+    bool frozen;
+    struct obj_key keys[];
 };
 
-struct obj_pair {
-    jsean key;
-    jsean val;
-};
+static inline jsean *obj_vals(const struct obj *obj)
+{
+    return (jsean *)&obj->keys[obj->cap];
+}
+
+static inline bool key_is_live(const struct obj_key *key)
+{
+    return key->ptr != NULL || key->small;
+}
+
+static inline const char *key_str(const struct obj_key *key)
+{
+    return key->small ? key->buf : key->ptr;
+}
+
+_Static_assert(sizeof(jsean) == 16, "jsean must be 16 bytes");
 
 struct strbuf {
+    const jsean_allocator *alloc;
     char *data;
     size_t cap;
     size_t len;
@@ -72,11 +184,11 @@ static inline size_t next_capacity(const size_t n)
     return n + (n >> 1) + (n >> 3);
 }
 
-unsigned int get_internal_type(const jsean *json);
-
 // These return false if they fail to allocate memory.
-bool strbuf_init(struct strbuf *buf);
+bool strbuf_init(struct strbuf *buf, const jsean_allocator *alloc);
 void strbuf_free(struct strbuf *buf);
+// Makes room for at least @n more bytes
+bool strbuf_reserve(struct strbuf *buf, size_t n);
 bool strbuf_add_byte(struct strbuf *buf, char byte);
 bool strbuf_add_bytes(struct strbuf *buf, const char *str, size_t len);
 bool strbuf_add_codepoint(struct strbuf *buf, int cp);
@@ -89,8 +201,101 @@ static inline void strbuf_clear(struct strbuf *buf)
 void obj_free(jsean *json);
 void arr_free(jsean *json);
 
+// Give an empty array or object storage from @alloc, so that nothing added to
+// it later comes from elsewhere. These return false if they fail to allocate
+// memory.
+bool arr_create(jsean *json, const jsean_allocator *alloc);
+bool obj_create(jsean *json, const jsean_allocator *alloc);
+
+// Same as jsean_obj_add(), but assumes the key is not in use, so the keys are
+// never compared. Used by the parser when keys are trusted to be unique.
+jsean *obj_add_unique(jsean *json, jsean *key, jsean *val);
+
+// Packs an array of numbers in place. Returns false if the array has values
+// of other types, or is frozen.
+bool arr_pack(jsean *json);
+
+// These return false if they fail to allocate memory.
+bool obj_freeze(jsean *json);
+bool arr_freeze(jsean *json);
+
+// Same as jsean_read_ex() and jsean_read_stream_ex(), but arrays, objects and
+// strings are allocated with @alloc
+int read_buffer_with(jsean *json, const char *str, size_t len,
+    unsigned int flags, const jsean_allocator *alloc);
+int read_stream_with(jsean *json, FILE *fp, unsigned int flags,
+    const jsean_allocator *alloc);
+
+// Checks that the text is valid JSON without building any values. Returns the
+// same status as jsean_read() would.
+int validate_buffer(const char *str, size_t len);
+
+// Size of the buffer that streaming output is gathered in before it is
+// handed to the sink
+#define WRITE_STREAM_BUFFER_SIZE    (1 << 16)
+
+// Size of the chunks that jsean_write_iov() writes text into, and the
+// shortest text that it points to instead of copying
+#define WRITE_IOV_CHUNK_SIZE        4096
+#define WRITE_IOV_REF_MIN           512
+
+// Fewest elements or members that jsean_write_parallel() gives a thread
+#define WRITE_PARALLEL_MIN          1024
+
+// Longest text written by num_format(), "-1.2345678901234567e-308"
+#define NUM_FORMAT_MAX              32
+
+// Writes the shortest text that reads back as @num into @buf, formatted like
+// JavaScript does, without a null terminator. Non-finite numbers are written
+// as null. Returns the length.
+size_t num_format(double num, char *buf);
+
 bool str_cmp(const jsean *json, const jsean *other);
 size_t str_hash(const jsean *json);
 void str_free(jsean *json);
 
+// Returns the index to store in jsean::s_free for strings freed with @fn,
+// adding it to the table if needed, or -1 if the table is full
+int free_fn_index(void (*fn)(void *));
+
+// Returns the index to store in jsean::s_free for strings allocated with
+// @alloc, or -1 if there are too many allocators
+int str_alloc_index(const jsean_allocator *alloc);
+
+// Returns true if the string's memory was allocated with @alloc
+bool str_from_alloc(const jsean *json, const jsean_allocator *alloc);
+
+static inline const char *str_ptr(const jsean *json)
+{
+    return json->s_small ? json->s_buf : json->s_val;
+}
+
+static inline size_t str_len(const jsean *json)
+{
+    return json->s_small ? json->s_small_len : json->s_len;
+}
+
+// Copies a string of at most STRING_SMALL_MAX bytes into the value itself
+static inline void str_set_small(jsean *json, const char *str, size_t len)
+{
+    memcpy(json->s_buf, str, len);
+    json->s_buf[len] = '\0';
+    json->s_small = 1;
+    json->s_small_len = len;
+    json->s_free = STRING_FREE_NONE;
+    json->s_known = 0;
+    json->type = JSEAN_TYPE_STRING;
+}
+
+// Records enum jsean_str_flags for the string
+static inline void str_set_flags(jsean *json, unsigned int flags)
+{
+    json->s_known = 1;
+    json->s_escape = !!(flags & JSEAN_STR_ESCAPE);
+    json->s_ascii = !!(flags & JSEAN_STR_ASCII);
+}
+
+// Returns enum jsean_str_flags for the bytes, by looking at all of them
+unsigned int str_scan(const char *str, size_t len);
+
 #endif // JSEAN_INTERNAL_H
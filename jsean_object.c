@@ -4,7 +4,10 @@
 // Licensed under the BSD 2-Clause License. See LICENSE.txt
 //
 
+#include <limits.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -16,58 +19,352 @@ static inline float get_load_factor(struct obj *obj)
     return (float)(obj->len + obj->dead) / obj->cap;
 }
 
-static struct obj *obj_init(void)
+static inline unsigned int key_hash(size_t hash)
+{
+    return hash & KEY_HASH_MASK;
+}
+
+static inline bool key_is_dead(const struct obj_key *key)
+{
+    return !key_is_live(key) && key->len == KEY_DEAD;
+}
+
+static inline bool key_eq(const struct obj_key *key, const char *str,
+    size_t len, unsigned int hash)
+{
+    return key->hash == hash && key->len == len
+        && memcmp(key_str(key), str, len) == 0;
+}
+
+// Stores the key in the slot. Short keys are copied into the slot, keys from
+// the object's own allocator are taken over, and other keys are copied, so a
+// single bit is enough to tell whether the key needs to be freed.
+static bool key_take(const jsean_allocator *alloc, struct obj_key *dst,
+    const jsean *key, unsigned int hash)
+{
+    const char *str;
+    size_t len;
+    char *ptr;
+
+    str = str_ptr(key);
+    len = str_len(key);
+
+    if (len <= KEY_SMALL_MAX) {
+        memset(dst->buf, 0, sizeof(dst->buf));
+        memcpy(dst->buf, str, len);
+        dst->small = 1;
+        dst->owned = 0;
+    } else if (key->s_small || (key->s_free != STRING_FREE_NONE
+            && !str_from_alloc(key, alloc))) {
+        ptr = mem_alloc(alloc, len);
+        if (!ptr)
+            return false;
+
+        memcpy(ptr, str, len);
+        dst->ptr = ptr;
+        dst->small = 0;
+        dst->owned = 1;
+    } else {
+        dst->ptr = key->s_val;
+        dst->small = 0;
+        dst->owned = key->s_free != STRING_FREE_NONE;
+
+        dst->len = len;
+        dst->hash = hash;
+        return true;
+    }
+
+    dst->len = len;
+    dst->hash = hash;
+
+    // The key was copied, so the original is not needed anymore
+    str_free((jsean *)key);
+
+    return true;
+}
+
+static inline void key_free(const jsean_allocator *alloc, struct obj_key *key)
+{
+    if (key->owned)
+        mem_free(alloc, key->ptr, key->len);
+}
+
+static inline size_t phf_buckets(size_t len)
+{
+    return (len + PHF_BUCKET_SIZE - 1) / PHF_BUCKET_SIZE;
+}
+
+// Size of the block for an object of @cap slots, and @nb buckets if frozen
+static inline size_t obj_size(size_t cap, size_t nb)
+{
+    return sizeof(struct obj) + (sizeof(struct obj_key) + sizeof(jsean)) * cap
+        + sizeof(unsigned int) * nb;
+}
+
+// Returns the smallest capacity that holds @n members without growing
+static inline size_t capacity_for(size_t n)
+{
+    size_t cap;
+
+    cap = n / OBJECT_LOAD_FACTOR_MAX + 1;
+
+    return cap > OBJECT_DEFAULT_CAPACITY ? cap : OBJECT_DEFAULT_CAPACITY;
+}
+
+// Allocates an empty object with a table of @cap slots, and room for @nb
+// buckets after it
+static struct obj *obj_init(const jsean_allocator *alloc, size_t cap, size_t nb)
 {
     struct obj *obj;
-    struct obj_pair *ptr, *end;
 
-    obj = malloc(sizeof(*obj));
+    obj = mem_alloc(alloc, obj_size(cap, nb));
     if (!obj)
         return NULL;
 
-    obj->cap = OBJECT_DEFAULT_CAPACITY;
+    obj->alloc = alloc;
+    obj->disp = NULL;
+    obj->cap = cap;
     obj->len = 0;
     obj->dead = 0;
+    obj->frozen = false;
 
-    ptr = malloc(sizeof(*ptr) * obj->cap);
-    if (!ptr)
+    memset(obj->keys, 0, sizeof(*obj->keys) * cap);
+
+    return obj;
+}
+
+static void obj_dealloc(struct obj *obj)
+{
+    mem_free(obj->alloc, obj, obj_size(obj->cap, obj->disp ? phf_buckets(obj->cap) : 0));
+}
+
+bool obj_create(jsean *json, const jsean_allocator *alloc)
+{
+    if (!json->ao_ptr)
+        json->ao_ptr = obj_init(alloc, 0, 0);
+
+    return json->ao_ptr != NULL;
+}
+
+// Moves the live pairs into a new object with a table of @cap slots, dropping
+// dead ones. Returns the new object, or NULL if out of memory, leaving the old
+// one as it was.
+static struct obj *obj_rehash(jsean *json, size_t cap)
+{
+    struct obj *obj = json->ao_ptr;
+    struct obj *tmp;
+    jsean *vals;
+    size_t i, j;
+
+    tmp = obj_init(obj->alloc, cap, 0);
+    if (!tmp)
         return NULL;
 
-    obj->ptr = ptr;
+    vals = obj_vals(tmp);
 
-    for (end = ptr + obj->cap; ptr != end; ptr++)
-        ptr->key.type = INTERNAL_TYPE_EMPTY;
+    for (i = 0; i < obj->cap; i++) {
+        if (!key_is_live(&obj->keys[i]))
+            continue;
 
-    return obj;
+        j = obj->keys[i].hash % cap;
+        while (key_is_live(&tmp->keys[j])) {
+            if (++j == cap)
+                j = 0;
+        }
+
+        tmp->keys[j] = obj->keys[i];
+        vals[j] = obj_vals(obj)[i];
+    }
+
+    tmp->len = obj->len;
+
+    obj_dealloc(obj);
+    json->ao_ptr = tmp;
+
+    return tmp;
+}
+
+// Mixes a key's hash with a seed, for frozen objects
+static inline size_t phf_mix(size_t hash, unsigned int seed)
+{
+    hash ^= seed * 0x9e3779b97f4a7c15;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccd;
+    hash ^= hash >> 33;
+
+    return hash;
 }
 
-static void obj_rehash(struct obj *obj, size_t old_cap)
+// Frozen objects use the full hash of the key, not the bits kept in the key,
+// so that keys rarely have the same hash
+static size_t phf_find(const struct obj *obj, const char *str, size_t len,
+    size_t hash)
 {
-    struct obj_pair *ptr, *end;
-    size_t index;
+    unsigned int disp;
+    size_t i;
 
-    for (ptr = obj->ptr; obj->dead > 0; ptr++) {
-        if (get_internal_type(&ptr->key) == INTERNAL_TYPE_DEAD) {
-            ptr->key.type = INTERNAL_TYPE_EMPTY;
-            obj->dead--;
+    disp = obj->disp[phf_mix(hash, 0) % phf_buckets(obj->len)];
+
+    if (disp & PHF_SLOT)
+        i = disp & ~PHF_SLOT;
+    else
+        i = phf_mix(hash, disp) % obj->len;
+
+    return key_eq(&obj->keys[i], str, len, key_hash(hash)) ? i : SIZE_MAX;
+}
+
+// Finds a seed that maps every key in the bucket to a free slot, and takes
+// those slots. Returns 0 if there is no such seed.
+static unsigned int phf_seed(const size_t *hashes, const unsigned int *next,
+    unsigned int head, size_t *slots, bool *taken, size_t n)
+{
+    unsigned int seed, k;
+    size_t j;
+
+    // No seed can separate keys with the same hash
+    for (k = head; k != UINT_MAX; k = next[k]) {
+        for (j = next[k]; j != UINT_MAX; j = next[j]) {
+            if (hashes[k] == hashes[j])
+                return 0;
         }
     }
 
-    for (ptr = obj->ptr, end = ptr + old_cap; ptr != end; ptr++) {
-        if (get_internal_type(&ptr->key) == INTERNAL_TYPE_EMPTY)
+    for (seed = 1; seed < PHF_SEED_MAX; seed++) {
+        for (k = head, j = 0; k != UINT_MAX; k = next[k], j++) {
+            slots[j] = phf_mix(hashes[k], seed) % n;
+            if (taken[slots[j]])
+                break;
+
+            taken[slots[j]] = true;
+        }
+
+        if (k == UINT_MAX)
+            return seed;
+
+        while (j-- > 0)
+            taken[slots[j]] = false;
+    }
+
+    return 0;
+}
+
+// Rebuilds the table into a minimal perfect hash with hash and displace. The
+// keys are split into buckets, and starting from the largest bucket, each one
+// gets the first seed that maps all of its keys to free slots. Buckets with a
+// single key are placed directly into the slots left over. The new table and
+// the buckets go into a new object. Returns false if out of memory, or if
+// some keys can't be separated.
+static bool phf_build(jsean *json)
+{
+    const jsean_allocator *tmp = default_allocator();
+    struct obj *obj = json->ao_ptr;
+    struct obj *frozen;
+    jsean *vals;
+    unsigned int *disp, *order, *head, *next, *count, *index, b, k;
+    size_t *hashes, *slots, n, nb, i, j, slot;
+    bool *taken, ok;
+
+    n = obj->len;
+    nb = phf_buckets(n);
+    ok = false;
+
+    frozen = obj_init(obj->alloc, n, nb);
+    order = mem_alloc(tmp, sizeof(*order) * nb);
+    head = mem_alloc(tmp, sizeof(*head) * nb);
+    count = mem_alloc(tmp, sizeof(*count) * nb);
+    next = mem_alloc(tmp, sizeof(*next) * n);
+    index = mem_alloc(tmp, sizeof(*index) * n);
+    hashes = mem_alloc(tmp, sizeof(*hashes) * n);
+    slots = mem_alloc(tmp, sizeof(*slots) * n);
+    taken = mem_alloc(tmp, sizeof(*taken) * n);
+    if (!frozen || !order || !head || !count || !next || !index || !hashes || !slots || !taken)
+        goto end;
+
+    vals = obj_vals(frozen);
+    disp = (unsigned int *)&vals[n];
+    memset(disp, 0, sizeof(*disp) * nb);
+    memset(count, 0, sizeof(*count) * nb);
+    memset(taken, 0, sizeof(*taken) * n);
+
+    for (i = 0; i < nb; i++) {
+        order[i] = i;
+        head[i] = UINT_MAX;
+    }
+
+    // Hash the keys, and link them into lists by bucket
+    for (i = 0, k = 0; i < obj->cap; i++) {
+        if (!key_is_live(&obj->keys[i]))
             continue;
 
-        index = str_hash(&ptr->key) % obj->cap;
-        while (get_internal_type(&ptr->key) != INTERNAL_TYPE_EMPTY) {
-            index++;
+        index[k] = i;
+        hashes[k] = __jsean_hash(key_str(&obj->keys[i]), obj->keys[i].len);
 
-            if (index >= obj->cap)
-                index = 0;
-        }
+        b = phf_mix(hashes[k], 0) % nb;
+        next[k] = head[b];
+        head[b] = k;
+        count[b]++;
+        k++;
+    }
 
-        memcpy(&obj->ptr[index], ptr, sizeof(*ptr));
-        ptr->key.type = INTERNAL_TYPE_EMPTY;
+    // Insertion sort is fine, as there are only a few distinct bucket sizes
+    for (i = 1; i < nb; i++) {
+        b = order[i];
+        for (j = i; j > 0 && count[order[j - 1]] < count[b]; j--)
+            order[j] = order[j - 1];
+        order[j] = b;
     }
+
+    for (i = 0; i < nb && count[order[i]] > 1; i++) {
+        b = order[i];
+
+        disp[b] = phf_seed(hashes, next, head[b], slots, taken, n);
+        if (!disp[b])
+            goto end;
+    }
+
+    for (slot = 0; i < nb && count[order[i]] == 1; i++) {
+        while (taken[slot])
+            slot++;
+
+        taken[slot] = true;
+        disp[order[i]] = slot | PHF_SLOT;
+    }
+
+    // Move the pairs into their final slots
+    for (b = 0; b < nb; b++) {
+        for (k = head[b]; k != UINT_MAX; k = next[k]) {
+            if (disp[b] & PHF_SLOT)
+                slot = disp[b] & ~PHF_SLOT;
+            else
+                slot = phf_mix(hashes[k], disp[b]) % n;
+
+            frozen->keys[slot] = obj->keys[index[k]];
+            vals[slot] = obj_vals(obj)[index[k]];
+        }
+    }
+
+    frozen->disp = disp;
+    frozen->len = n;
+
+    obj_dealloc(obj);
+    json->ao_ptr = frozen;
+
+    frozen = NULL;
+    ok = true;
+
+end:
+    if (frozen)
+        obj_dealloc(frozen);
+    mem_free(tmp, order, sizeof(*order) * nb);
+    mem_free(tmp, head, sizeof(*head) * nb);
+    mem_free(tmp, count, sizeof(*count) * nb);
+    mem_free(tmp, next, sizeof(*next) * n);
+    mem_free(tmp, index, sizeof(*index) * n);
+    mem_free(tmp, hashes, sizeof(*hashes) * n);
+    mem_free(tmp, slots, sizeof(*slots) * n);
+    mem_free(tmp, taken, sizeof(*taken) * n);
+
+    return ok;
 }
 
 int jsean_set_obj(jsean *json)
@@ -93,10 +390,122 @@ size_t jsean_obj_len(const jsean *json)
     return obj ? obj->len : 0;
 }
 
-jsean *jsean_obj_at(const jsean *json, const jsean *key)
+// Returns the slot with the key, or SIZE_MAX if there is no such key
+static size_t obj_find(const struct obj *obj, const char *str, size_t len,
+    size_t hash)
+{
+    const struct obj_key *key;
+    size_t i;
+
+    if (!obj || !obj->len)
+        return SIZE_MAX;
+
+    if (obj->disp)
+        return phf_find(obj, str, len, hash);
+
+    for (i = key_hash(hash) % obj->cap;; i++) {
+        if (i == obj->cap)
+            i = 0;
+
+        key = &obj->keys[i];
+
+        if (key_is_live(key)) {
+            if (key_eq(key, str, len, key_hash(hash)))
+                return i;
+        } else if (!key_is_dead(key)) {
+            return SIZE_MAX;
+        }
+    }
+}
+
+// Finds the slot for the key in a single probe. Returns the slot with the key,
+// or if there is none, the first dead or empty slot the key can go into. With
+// @unique, keys are not compared, and the first free slot is returned.
+static size_t obj_probe(struct obj *obj, const char *str, size_t len,
+    unsigned int hash, bool unique)
+{
+    const struct obj_key *key;
+    size_t i, dead;
+
+    dead = SIZE_MAX;
+
+    for (i = hash % obj->cap;; i++) {
+        if (i == obj->cap)
+            i = 0;
+
+        key = &obj->keys[i];
+
+        if (key_is_live(key)) {
+            if (!unique && key_eq(key, str, len, hash))
+                return i;
+        } else if (key_is_dead(key)) {
+            if (unique)
+                return i;
+            if (dead == SIZE_MAX)
+                dead = i;
+        } else {
+            return dead != SIZE_MAX ? dead : i;
+        }
+    }
+}
+
+// Returns the value for the key, and whether the key was already in use. If it
+// was not, the key is stored and the value is set to null. The object may
+// move.
+static jsean *obj_entry(jsean *json, const jsean *key, size_t hash,
+    bool unique, bool *found)
+{
+    struct obj *obj = json->ao_ptr;
+    size_t i;
+    bool dead;
+
+    if (!obj->cap) {
+        if ((obj = obj_rehash(json, OBJECT_DEFAULT_CAPACITY)) == NULL)
+            return NULL;
+    } else if (get_load_factor(obj) > OBJECT_LOAD_FACTOR_MAX) {
+        if ((obj = obj_rehash(json, next_capacity(obj->cap))) == NULL)
+            return NULL;
+    }
+
+    i = obj_probe(obj, str_ptr(key), str_len(key), key_hash(hash), unique);
+
+    *found = key_is_live(&obj->keys[i]);
+    if (*found)
+        return &obj_vals(obj)[i];
+
+    dead = key_is_dead(&obj->keys[i]);
+
+    if (!key_take(obj->alloc, &obj->keys[i], key, key_hash(hash)))
+        return NULL;
+
+    if (dead)
+        obj->dead--;
+
+    jsean_set_null(&obj_vals(obj)[i]);
+    obj->len++;
+
+    return &obj_vals(obj)[i];
+}
+
+static inline struct obj *get_mutable_obj(jsean *json)
 {
     struct obj *obj;
-    struct obj_pair *ptr, *end;
+
+    if (!json->ao_ptr && (json->ao_ptr = obj_init(default_allocator(), OBJECT_DEFAULT_CAPACITY, 0)) == NULL)
+        return NULL;
+
+    obj = json->ao_ptr;
+    return obj->frozen ? NULL : obj;
+}
+
+static inline jsean *get_val(const struct obj *obj, size_t i)
+{
+    return i != SIZE_MAX ? &obj_vals(obj)[i] : NULL;
+}
+
+jsean *jsean_obj_at(const jsean *json, const jsean *key)
+{
+    const struct obj *obj;
 
     if (jsean_get_type(json) != JSEAN_TYPE_OBJECT)
         return NULL;
@@ -105,34 +514,114 @@ jsean *jsean_obj_at(const jsean *json, const jsean *key)
         return NULL;
 
     obj = json->ao_ptr;
-    if (!obj)
+
+    return get_val(obj, obj_find(obj, str_ptr(key), str_len(key), str_hash(key)));
+}
+
+jsean *jsean_obj_at_key(const jsean *json, const jsean_key *key)
+{
+    const struct obj *obj;
+
+    if (jsean_get_type(json) != JSEAN_TYPE_OBJECT || !key)
         return NULL;
 
-    ptr = obj->ptr + (str_hash(key) % obj->cap);
-    end = ptr + obj->cap;
+    obj = json->ao_ptr;
 
-    for (;; ptr++) {
-        if (ptr == end)
-            ptr = obj->ptr;
+    return get_val(obj, obj_find(obj, key->k_val, key->k_len, key->k_hash));
+}
 
-        if (get_internal_type(&ptr->key) == INTERNAL_TYPE_EMPTY)
-            return NULL;
+// Resolves up to OBJECT_BATCH_SIZE keys. All home slots are prefetched first,
+// so the cache misses overlap instead of happening one after another.
+static size_t obj_find_batch(const struct obj *obj, const jsean_key *keys,
+    size_t n, jsean **out)
+{
+    size_t i, found;
+
+    if (obj->disp) {
+        for (i = 0; i < n; i++)
+            __builtin_prefetch(&obj->disp[phf_mix(keys[i].k_hash, 0) % phf_buckets(obj->len)]);
+    } else {
+        for (i = 0; i < n; i++)
+            __builtin_prefetch(&obj->keys[key_hash(keys[i].k_hash) % obj->cap]);
+    }
+
+    for (i = 0, found = 0; i < n; i++) {
+        out[i] = get_val(obj, obj_find(obj, keys[i].k_val, keys[i].k_len, keys[i].k_hash));
+
+        if (out[i])
+            found++;
+    }
+
+    return found;
+}
 
-        if (get_internal_type(&ptr->key) == INTERNAL_TYPE_DEAD)
+size_t jsean_obj_get_many(const jsean *json, const jsean *keys, size_t n,
+    jsean **out)
+{
+    jsean_key batch[OBJECT_BATCH_SIZE];
+    const struct obj *obj;
+    size_t i, j, len, found;
+
+    if (!keys || !out)
+        return 0;
+
+    obj = jsean_get_type(json) == JSEAN_TYPE_OBJECT ? json->ao_ptr : NULL;
+
+    for (i = 0, found = 0; i < n; i += len) {
+        len = n - i < OBJECT_BATCH_SIZE ? n - i : OBJECT_BATCH_SIZE;
+
+        if (!obj || !obj->len) {
+            memset(&out[i], 0, sizeof(*out) * len);
             continue;
+        }
+
+        for (j = 0; j < len; j++) {
+            // Non-string keys are never found
+            if (jsean_get_type(&keys[i + j]) != JSEAN_TYPE_STRING) {
+                batch[j].k_val = NULL;
+                batch[j].k_len = UINT_MAX;
+                batch[j].k_hash = STRING_HASH_UNDEFINED;
+                continue;
+            }
+
+            batch[j].k_val = str_ptr(&keys[i + j]);
+            batch[j].k_len = str_len(&keys[i + j]);
+            batch[j].k_hash = str_hash(&keys[i + j]);
+        }
 
-        if (str_cmp(&ptr->key, key))
-            return &ptr->val;
+        found += obj_find_batch(obj, batch, len, &out[i]);
     }
 
-    return NULL;
+    return found;
+}
+
+size_t jsean_obj_get_many_key(const jsean *json, const jsean_key *keys,
+    size_t n, jsean **out)
+{
+    const struct obj *obj;
+    size_t i, len, found;
+
+    if (!keys || !out)
+        return 0;
+
+    obj = jsean_get_type(json) == JSEAN_TYPE_OBJECT ? json->ao_ptr : NULL;
+    if (!obj || !obj->len) {
+        memset(out, 0, sizeof(*out) * n);
+        return 0;
+    }
+
+    for (i = 0, found = 0; i < n; i += len) {
+        len = n - i < OBJECT_BATCH_SIZE ? n - i : OBJECT_BATCH_SIZE;
+        found += obj_find_batch(obj, &keys[i], len, &out[i]);
+    }
+
+    return found;
 }
 
 jsean *jsean_obj_add(jsean *json, jsean *key, jsean *val)
 {
-    struct obj *obj;
-    struct obj_pair *ptr, *end;
-    size_t old_cap;
+    jsean *ptr;
+    bool found;
 
     if (jsean_get_type(json) != JSEAN_TYPE_OBJECT)
         return NULL;
@@ -143,54 +632,45 @@ jsean *jsean_obj_add(jsean *json, jsean *key, jsean *val)
     if (jsean_get_type(val) == JSEAN_TYPE_UNKNOWN)
         return NULL;
 
-    if (!json->ao_ptr && (json->ao_ptr = obj_init()) == NULL)
+    if (!get_mutable_obj(json))
         return NULL;
 
-    obj = json->ao_ptr;
-
-    if (get_load_factor(obj) > OBJECT_LOAD_FACTOR_MAX) {
-        old_cap = obj->cap;
-
-        ptr = realloc(obj->ptr, sizeof(*ptr) * next_capacity(old_cap));
-        if (!ptr)
-            return NULL;
-
-        obj->cap = next_capacity(old_cap);
-
-        for (end = ptr + obj->cap; ptr != end; ptr++)
-            ptr->key.type = INTERNAL_TYPE_EMPTY;
-
-        obj->ptr = ptr;
-        obj_rehash(obj, old_cap);
-    }
+    ptr = obj_entry(json, key, str_hash(key), false, &found);
+    if (!ptr || found)
+        return NULL;
 
-    ptr = obj->ptr + (str_hash(key) % obj->cap);
-    end = ptr + obj->cap;
+    // The key's string may have been copied and freed
+    jsean_set_null(key);
 
-    for (;; ptr++) {
-        if (ptr == end)
-            ptr = obj->ptr;
+    mem_adopt(((struct obj *)json->ao_ptr)->alloc, val);
+    memcpy(ptr, val, sizeof(*val));
+    return ptr;
+}
 
-        if (get_internal_type(&ptr->key) == INTERNAL_TYPE_EMPTY)
-            break;
+// Same as jsean_obj_entry(), but the arguments are not checked
+static jsean *obj_entry_take(jsean *json, jsean *key, bool *found)
+{
+    jsean *ptr;
 
-        if (get_internal_type(&ptr->key) == INTERNAL_TYPE_DEAD)
-            continue;
+    if (!get_mutable_obj(json))
+        return NULL;
 
-        if (str_cmp(&ptr->key, key))
-            return NULL;
-    }
+    ptr = obj_entry(json, key, str_hash(key), false, found);
+    if (!ptr)
+        return NULL;
 
-    memcpy(&ptr->key, key, sizeof(*key));
-    memcpy(&ptr->val, val, sizeof(*val));
-    obj->len++;
+    // The key is now owned by the object, unless it was already in use
+    if (*found)
+        str_free(key);
+    jsean_set_null(key);
 
-    return &ptr->val;
+    return ptr;
 }
 
 jsean *jsean_obj_set(jsean *json, jsean *key, jsean *val)
 {
     jsean *ptr;
+    bool found;
 
     if (jsean_get_type(json) != JSEAN_TYPE_OBJECT)
         return NULL;
@@ -201,30 +681,109 @@ jsean *jsean_obj_set(jsean *json, jsean *key, jsean *val)
     if (jsean_get_type(val) == JSEAN_TYPE_UNKNOWN)
         return NULL;
 
-    if (!json->ao_ptr && (json->ao_ptr = obj_init()) == NULL)
+    ptr = obj_entry_take(json, key, &found);
+    if (!ptr)
         return NULL;
 
-    ptr = jsean_obj_at(json, key);
-    if (!ptr) {
-        ptr = jsean_obj_add(json, key, val);
-        if (ptr)
-            jsean_set_null(key);
+    jsean_free(ptr);
+    mem_adopt(((struct obj *)json->ao_ptr)->alloc, val);
+    memcpy(ptr, val, sizeof(*val));
 
-        return ptr;
-    }
+    return ptr;
+}
+
+jsean *jsean_obj_set_key(jsean *json, const jsean_key *key, jsean *val)
+{
+    jsean tmp, *ptr;
+    bool found;
+
+    if (jsean_get_type(json) != JSEAN_TYPE_OBJECT || !key)
+        return NULL;
+
+    if (jsean_get_type(val) == JSEAN_TYPE_UNKNOWN)
+        return NULL;
+
+    if (!get_mutable_obj(json))
+        return NULL;
+
+    tmp.s_val = (char *)key->k_val;
+    tmp.s_len = key->k_len;
+    tmp.s_free = STRING_FREE_NONE;
+    tmp.s_small = 0;
+    tmp.type = JSEAN_TYPE_STRING;
+
+    ptr = obj_entry(json, &tmp, key->k_hash, false, &found);
+    if (!ptr)
+        return NULL;
 
     jsean_free(ptr);
+    mem_adopt(((struct obj *)json->ao_ptr)->alloc, val);
     memcpy(ptr, val, sizeof(*val));
 
-    jsean_set_null(key);
+    return ptr;
+}
+
+jsean *jsean_obj_entry(jsean *json, jsean *key, bool *found)
+{
+    jsean *ptr;
+    bool dup;
+
+    if (jsean_get_type(json) != JSEAN_TYPE_OBJECT)
+        return NULL;
 
+    if (jsean_get_type(key) != JSEAN_TYPE_STRING)
+        return NULL;
+
+    ptr = obj_entry_take(json, key, &dup);
+    if (!ptr)
+        return NULL;
+
+    // The caller fills in the value, so it cannot be checked
+    mem_adopt(((struct obj *)json->ao_ptr)->alloc, NULL);
+
+    if (found)
+        *found = dup;
+
+    return ptr;
+}
+
+jsean *obj_add_unique(jsean *json, jsean *key, jsean *val)
+{
+    jsean *ptr;
+    bool found;
+
+    if (!get_mutable_obj(json))
+        return NULL;
+
+    ptr = obj_entry(json, key, str_hash(key), true, &found);
+    if (!ptr)
+        return NULL;
+
+    mem_adopt(((struct obj *)json->ao_ptr)->alloc, val);
+    memcpy(ptr, val, sizeof(*val));
     return ptr;
 }
 
+static void obj_clear(struct obj *obj)
+{
+    for (size_t i = 0; i < obj->cap; i++) {
+        if (!key_is_live(&obj->keys[i]))
+            continue;
+
+        key_free(obj->alloc, &obj->keys[i]);
+        jsean_free(&obj_vals(obj)[i]);
+    }
+
+    memset(obj->keys, 0, sizeof(*obj->keys) * obj->cap);
+
+    obj->len = 0;
+    obj->dead = 0;
+}
+
 void jsean_obj_del(jsean *json, const jsean *key)
 {
     struct obj *obj;
-    struct obj_pair *ptr, *end;
+    size_t i;
 
     if (jsean_get_type(json) != JSEAN_TYPE_OBJECT)
         return;
@@ -233,61 +792,82 @@ void jsean_obj_del(jsean *json, const jsean *key)
         return;
 
     obj = json->ao_ptr;
-    if (!obj || obj->len == 0)
+    if (!obj || obj->frozen)
         return;
 
-    ptr = obj->ptr + (str_hash(key) % obj->cap);
-    end = ptr + obj->cap;
-
-    for (;; ptr++) {
-        if (ptr == end)
-            ptr = obj->ptr;
-
-        if (get_internal_type(&ptr->key) == INTERNAL_TYPE_EMPTY)
-            break;
+    i = obj_find(obj, str_ptr(key), str_len(key), str_hash(key));
+    if (i == SIZE_MAX)
+        return;
 
-        if (get_internal_type(&ptr->key) == INTERNAL_TYPE_DEAD)
-            continue;
+    key_free(obj->alloc, &obj->keys[i]);
+    jsean_free(&obj_vals(obj)[i]);
 
-        if (str_cmp(&ptr->key, key)) {
-            str_free(&ptr->key);
-            jsean_free(&ptr->val);
+    obj->keys[i].ptr = NULL;
+    obj->keys[i].len = KEY_DEAD;
+    obj->keys[i].small = 0;
 
-            ptr->key.type = INTERNAL_TYPE_DEAD;
+    obj->len--;
+    obj->dead++;
 
-            obj->len--;
-            obj->dead++;
-        }
-    }
+    // Without members, the dead slots are easy to get rid of
+    if (!obj->len)
+        obj_clear(obj);
 }
 
 void jsean_obj_clear(jsean *json)
 {
     struct obj *obj;
-    struct obj_pair *ptr, *end;
 
     if (jsean_get_type(json) != JSEAN_TYPE_OBJECT)
         return;
 
     obj = json->ao_ptr;
-    if (!obj || obj->len == 0)
+    if (!obj || obj->len == 0 || obj->frozen)
         return;
 
-    for (ptr = obj->ptr, end = ptr + obj->cap; ptr != end; ptr++) {
-        if (get_internal_type(&ptr->key) == INTERNAL_TYPE_EMPTY)
-            continue;
-        else if (get_internal_type(&ptr->key) == INTERNAL_TYPE_DEAD)
-            continue;
-        else {
-            str_free(&ptr->key);
-            jsean_free(&ptr->val);
+    obj_clear(obj);
+}
 
-            ptr->key.type = INTERNAL_TYPE_EMPTY;
-        }
+int jsean_obj_reserve(jsean *json, size_t n)
+{
+    struct obj *obj;
+
+    if (jsean_get_type(json) != JSEAN_TYPE_OBJECT || n > UINT_MAX / 2)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (!json->ao_ptr) {
+        json->ao_ptr = obj_init(default_allocator(), capacity_for(n), 0);
+        return json->ao_ptr ? JSEAN_SUCCESS : JSEAN_OUT_OF_MEMORY;
     }
 
-    obj->len = 0;
-    obj->dead = 0;
+    obj = json->ao_ptr;
+    if (obj->frozen)
+        return JSEAN_FROZEN;
+
+    if (capacity_for(n) <= obj->cap)
+        return JSEAN_SUCCESS;
+
+    return obj_rehash(json, capacity_for(n)) ? JSEAN_SUCCESS : JSEAN_OUT_OF_MEMORY;
+}
+
+int jsean_obj_compact(jsean *json)
+{
+    struct obj *obj;
+
+    if (jsean_get_type(json) != JSEAN_TYPE_OBJECT)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    obj = json->ao_ptr;
+    if (!obj)
+        return JSEAN_SUCCESS;
+
+    if (obj->frozen)
+        return JSEAN_FROZEN;
+
+    if (!obj->dead && capacity_for(obj->len) >= obj->cap)
+        return JSEAN_SUCCESS;
+
+    return obj_rehash(json, capacity_for(obj->len)) ? JSEAN_SUCCESS : JSEAN_OUT_OF_MEMORY;
 }
 
 void obj_free(jsean *json)
@@ -297,8 +877,38 @@ void obj_free(jsean *json)
     if (!obj)
         return;
 
-    jsean_obj_clear(json);
+    obj_clear(obj);
+    obj_dealloc(obj);
+}
+
+bool obj_freeze(jsean *json)
+{
+    struct obj *obj = json->ao_ptr;
+
+    if (!obj) {
+        if (!obj_create(json, default_allocator()))
+            return false;
+
+        ((struct obj *)json->ao_ptr)->frozen = true;
+        return true;
+    }
+
+    if (obj->frozen)
+        return true;
+
+    for (size_t i = 0; i < obj->cap; i++) {
+        if (!key_is_live(&obj->keys[i]))
+            continue;
+
+        if (jsean_freeze(&obj_vals(obj)[i]) != JSEAN_SUCCESS)
+            return false;
+    }
+
+    // Without a perfect hash, the object keeps its table, which works just
+    // as well, only slower
+    if (obj->len > 0)
+        phf_build(json);
 
-    free(obj->ptr);
-    free(obj);
+    ((struct obj *)json->ao_ptr)->frozen = true;
+    return true;
 }
@@ -0,0 +1,219 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsean.h"
+#include "jsean_internal.h"
+
+// A free block. The first block of a batch also holds the batch's last block
+// and number of blocks, and a link to the next batch in the depot.
+struct block {
+    struct block *next;
+    struct block *next_batch;
+    struct block *last;
+    size_t count;
+};
+
+_Static_assert(sizeof(struct block) <= POOL_CLASS_MIN, "struct block must fit in the smallest blocks");
+
+// Each thread keeps its own free lists, so allocating and freeing take no
+// locks. Blocks freed by another thread go into that thread's lists.
+struct cache {
+    struct block *head[POOL_CLASS_COUNT];
+    size_t count[POOL_CLASS_COUNT];
+};
+
+static _Thread_local struct cache cache;
+
+// Batches of blocks that threads have handed off, shared by all threads.
+// Batches are only ever pushed one at a time, and taken all at once, so
+// there is no ABA problem.
+static _Atomic(struct block *) depot[POOL_CLASS_COUNT];
+
+// Returns the size class for @size, or -1 if it is too large for the pool
+static inline int size_class(size_t size)
+{
+    if (size <= POOL_CLASS_MIN)
+        return 0;
+
+    if (size > POOL_CLASS_MAX)
+        return -1;
+
+    return (int)(sizeof(long) * CHAR_BIT) - __builtin_clzl(size - 1) - POOL_CLASS_SHIFT;
+}
+
+static inline size_t class_size(int c)
+{
+    return (size_t)POOL_CLASS_MIN << c;
+}
+
+static void depot_push(int c, struct block *batch, struct block *last,
+    size_t count)
+{
+    struct block *head;
+
+    batch->last = last;
+    batch->count = count;
+    head = atomic_load_explicit(&depot[c], memory_order_relaxed);
+
+    do {
+        batch->next_batch = head;
+    } while (!atomic_compare_exchange_weak_explicit(&depot[c], &head, batch,
+        memory_order_release, memory_order_relaxed));
+}
+
+// Moves every batch in the depot to the thread's free list
+static bool depot_take(int c)
+{
+    struct block *batch, *next;
+
+    batch = atomic_exchange_explicit(&depot[c], NULL, memory_order_acquire);
+    if (!batch)
+        return false;
+
+    for (; batch; batch = next) {
+        next = batch->next_batch;
+
+        batch->last->next = cache.head[c];
+        cache.head[c] = batch;
+        cache.count[c] += batch->count;
+    }
+
+    return true;
+}
+
+// Hands off the first @count blocks of the thread's free list to the depot
+static void cache_spill(int c, size_t count)
+{
+    struct block *batch, *last;
+
+    batch = last = cache.head[c];
+    for (size_t i = 1; i < count; i++)
+        last = last->next;
+
+    cache.head[c] = last->next;
+    cache.count[c] -= count;
+
+    last->next = NULL;
+    depot_push(c, batch, last, count);
+}
+
+static void *pool_alloc(void *ctx, size_t size)
+{
+    struct block *block;
+    int c;
+
+    (void)ctx;
+
+    c = size_class(size);
+    if (c < 0)
+        return malloc(size);
+
+    if (!cache.head[c] && !depot_take(c))
+        return malloc(class_size(c));
+
+    block = cache.head[c];
+    cache.head[c] = block->next;
+    cache.count[c]--;
+
+    return block;
+}
+
+static void pool_free(void *ctx, void *ptr, size_t size)
+{
+    struct block *block = ptr;
+    int c;
+
+    (void)ctx;
+
+    if (!ptr)
+        return;
+
+    c = size_class(size);
+    if (c < 0) {
+        free(ptr);
+        return;
+    }
+
+    block->next = cache.head[c];
+    cache.head[c] = block;
+
+    // Keep the other half for this thread, so that it does not hand off
+    // and take back the same blocks
+    if (++cache.count[c] > POOL_CACHE_MAX)
+        cache_spill(c, POOL_CACHE_MAX / 2);
+}
+
+static void *pool_realloc(void *ctx, void *ptr, size_t old_size, size_t size)
+{
+    int old_class, new_class;
+    void *tmp;
+
+    if (!ptr)
+        return pool_alloc(ctx, size);
+
+    old_class = size_class(old_size);
+    new_class = size_class(size);
+
+    if (old_class < 0 && new_class < 0)
+        return realloc(ptr, size);
+
+    // The block already has room for the new size
+    if (old_class == new_class)
+        return ptr;
+
+    tmp = pool_alloc(ctx, size);
+    if (!tmp)
+        return NULL;
+
+    memcpy(tmp, ptr, old_size < size ? old_size : size);
+    pool_free(ctx, ptr, old_size);
+
+    return tmp;
+}
+
+static const jsean_allocator pool_allocator = {
+    .alloc = pool_alloc,
+    .realloc = pool_realloc,
+    .free = pool_free,
+    .ctx = NULL,
+};
+
+const jsean_allocator *jsean_pool_allocator(void)
+{
+    return &pool_allocator;
+}
+
+void jsean_pool_flush(void)
+{
+    for (int c = 0; c < POOL_CLASS_COUNT; c++) {
+        if (cache.count[c])
+            cache_spill(c, cache.count[c]);
+    }
+}
+
+void jsean_pool_trim(void)
+{
+    struct block *block, *next;
+
+    for (int c = 0; c < POOL_CLASS_COUNT; c++) {
+        depot_take(c);
+
+        for (block = cache.head[c]; block; block = next) {
+            next = block->next;
+            free(block);
+        }
+
+        cache.head[c] = NULL;
+        cache.count[c] = 0;
+    }
+}
@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <string.h>
+
+#include "jsean.h"
+#include "jsean_internal.h"
+
+int jsean_set_raw(jsean *json, char *str, size_t len, void (*free_fn)(void *))
+{
+    int idx;
+
+    if (!json || !str || len > STRING_LENGTH_MAX)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (!len) {
+        len = strlen(str);
+
+        if (len > STRING_LENGTH_MAX)
+            return JSEAN_INVALID_ARGUMENTS;
+    }
+
+    idx = free_fn_index(free_fn);
+    if (idx < 0)
+        return JSEAN_TOO_MANY_FREE_FUNCTIONS;
+
+    // Never stored in the value itself, so it's freed like a long string
+    json->s_val = str;
+    json->s_len = len;
+    json->s_free = idx;
+    json->s_small = 0;
+    json->type = JSEAN_TYPE_RAW;
+
+    return JSEAN_SUCCESS;
+}
+
+int jsean_set_raw_checked(jsean *json, char *str, size_t len, void (*free_fn)(void *))
+{
+    int ret;
+
+    if (!json || !str || len > STRING_LENGTH_MAX)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (!len)
+        len = strlen(str);
+
+    ret = validate_buffer(str, len);
+    if (ret != JSEAN_SUCCESS)
+        return ret;
+
+    return jsean_set_raw(json, str, len, free_fn);
+}
+
+const char *jsean_get_raw(const jsean *json)
+{
+    if (jsean_get_type(json) != JSEAN_TYPE_RAW)
+        return NULL;
+
+    return json->s_val;
+}
+
+size_t jsean_raw_len(const jsean *json)
+{
+    if (jsean_get_type(json) != JSEAN_TYPE_RAW)
+        return 0;
+
+    return json->s_len;
+}
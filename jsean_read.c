@@ -16,6 +16,15 @@
 
 struct parser {
     struct strbuf buf;
+    unsigned int flags;
+    const jsean_allocator *alloc;
+    unsigned int s_free;
+
+    // Only check the text. Strings aren't copied, and every value is read as
+    // null, so nothing is allocated for it, and freeing it on errors does
+    // nothing.
+    bool validate;
+
     union {
         struct {
             const char *ptr, *end;
@@ -121,6 +130,15 @@ static void skip_whitespace(struct parser *p)
         READ(p);
 }
 
+static inline jsean *add_member(struct parser *p, jsean *json, jsean *name,
+    jsean *value)
+{
+    if (p->flags & JSEAN_READ_UNIQUE_KEYS)
+        return obj_add_unique(json, name, value);
+
+    return jsean_obj_set(json, name, value);
+}
+
 // object = begin-object [ member *( value-separator member ) ]
 //          end-object
 // member = string name-separator value
@@ -135,7 +153,13 @@ static int parse_object(struct parser *p, jsean *json)
     jsean name, value;
     int ret;
 
-    jsean_set_obj(json);
+    if (p->validate)
+        jsean_set_null(json);
+    else
+        jsean_set_obj(json);
+
+    if (p->alloc != default_allocator() && !obj_create(json, p->alloc))
+        return JSEAN_OUT_OF_MEMORY;
 
     READ(p);
 
@@ -156,7 +180,8 @@ static int parse_object(struct parser *p, jsean *json)
     ret = parse_value(p, &value);              \
     if (ret != JSEAN_SUCCESS)                  \
         goto err_name;                         \
-    if (!jsean_obj_set(json, &name, &value)) { \
+    if (!p->validate &&                        \
+        !add_member(p, json, &name, &value)) { \
         ret = JSEAN_OUT_OF_MEMORY;             \
         goto err_value;                        \
     }
@@ -203,7 +228,17 @@ static int parse_array(struct parser *p, jsean *json)
     jsean value;
     int ret;
 
-    jsean_set_arr(json);
+    if (p->validate)
+        jsean_set_null(json);
+    else
+        jsean_set_arr(json);
+
+    // Empty arrays and objects would get their storage from the default
+    // allocator when first added to, so with any other allocator they get
+    // it up front. In a document, nothing added to them later comes from
+    // the heap then.
+    if (p->alloc != default_allocator() && !arr_create(json, p->alloc))
+        return JSEAN_OUT_OF_MEMORY;
 
     READ(p);
 
@@ -216,7 +251,8 @@ static int parse_array(struct parser *p, jsean *json)
     if (ret != JSEAN_SUCCESS)            \
         goto err;                        \
                                          \
-    if (!jsean_arr_push(json, &value)) { \
+    if (!p->validate &&                  \
+        !jsean_arr_push(json, &value)) { \
         ret = JSEAN_OUT_OF_MEMORY;       \
         goto err_value;                  \
     }
@@ -237,6 +273,10 @@ static int parse_array(struct parser *p, jsean *json)
         PARSE_VALUE_HELPER();
     }
 
+    // Arrays with anything but numbers stay as they are
+    if ((p->flags & JSEAN_READ_PACK_NUMBERS) && !p->validate)
+        arr_pack(json);
+
 end:
     READ(p);
     return JSEAN_SUCCESS;
@@ -311,6 +351,12 @@ static int parse_number(struct parser *p, jsean *json)
             strbuf_add_byte(&p->buf, READ(p));
     }
 
+    // The text is a number by now, and converting it is what takes time
+    if (p->validate) {
+        jsean_set_null(json);
+        return JSEAN_SUCCESS;
+    }
+
     strbuf_add_byte(&p->buf, '\0');
 
     num = strtod(p->buf.data, &endptr);
@@ -416,7 +462,7 @@ static int parse_utf8_sequence(struct parser *p)
 #undef B
 
 end:
-    if (!strbuf_add_bytes(&p->buf, buf, len))
+    if (!p->validate && !strbuf_add_bytes(&p->buf, buf, len))
         return JSEAN_OUT_OF_MEMORY;
 
     return JSEAN_SUCCESS;
@@ -442,6 +488,7 @@ end:
 //
 static int parse_string(struct parser *p, jsean *json)
 {
+    unsigned int flags = JSEAN_STR_ASCII;
     char *ptr;
     int ret;
 
@@ -459,12 +506,29 @@ static int parse_string(struct parser *p, jsean *json)
         case '"':
             READ(p);
 
-            ptr = malloc(p->buf.len);
+            if (p->validate) {
+                jsean_set_null(json);
+                return JSEAN_SUCCESS;
+            }
+
+            if (p->buf.len <= STRING_SMALL_MAX) {
+                str_set_small(json, p->buf.data, p->buf.len);
+                str_set_flags(json, flags);
+                return JSEAN_SUCCESS;
+            }
+
+            ptr = mem_alloc(p->alloc, p->buf.len);
             if (!ptr)
                 return JSEAN_OUT_OF_MEMORY;
 
+            // Strings in a document are freed with the document
             memcpy(ptr, p->buf.data, p->buf.len);
-            jsean_set_str(json, ptr, p->buf.len, free);
+            json->s_val = ptr;
+            json->s_len = p->buf.len;
+            json->s_free = p->s_free;
+            json->s_small = 0;
+            json->type = JSEAN_TYPE_STRING;
+            str_set_flags(json, flags);
 
             return JSEAN_SUCCESS;
 
@@ -472,7 +536,9 @@ static int parse_string(struct parser *p, jsean *json)
         case 0x20 ... 0x21:
         case 0x23 ... 0x5b:
         case 0x5d ... 0x7f:
-            if (!strbuf_add_byte(&p->buf, READ(p)))
+            if (p->validate)
+                READ(p);
+            else if (!strbuf_add_byte(&p->buf, READ(p)))
                 return JSEAN_OUT_OF_MEMORY;
             break;
 
@@ -498,12 +564,24 @@ static int parse_string(struct parser *p, jsean *json)
                 return JSEAN_INVALID_ESCAPE_SEQUENCE;
             }
 
-            if (!strbuf_add_codepoint(&p->buf, ret))
+            if (ret < 0x20 || ret == '"' || ret == '\\')
+                flags |= JSEAN_STR_ESCAPE;
+            else if (ret > 0x7f)
+                flags &= ~JSEAN_STR_ASCII;
+
+            if (!p->validate && !strbuf_add_codepoint(&p->buf, ret))
                 return JSEAN_OUT_OF_MEMORY;
             break;
 
-        // Non-ASCII characters
+        // Non-ASCII characters, and control characters that weren't escaped
         default:
+            // Bytes above 0x7f may peek as negative
+            ret = PEEK(p);
+            if (ret >= 0 && ret < 0x20)
+                flags |= JSEAN_STR_ESCAPE;
+            else
+                flags &= ~JSEAN_STR_ASCII;
+
             ret = parse_utf8_sequence(p);
             if (ret != JSEAN_SUCCESS)
                 return ret;
@@ -579,51 +657,223 @@ static int parse_text(struct parser *p, jsean *json)
         return ret;
 
     skip_whitespace(p);
-    if (PEEK(p) != -1)
+    if (PEEK(p) != -1) {
+        jsean_free(json);
         return JSEAN_EXPECTED_WHITESPACE;
+    }
 
     return JSEAN_SUCCESS;
 }
 
 int jsean_read(jsean *json, jsean *src)
 {
-    struct parser p;
-    int ret;
+    return jsean_read_ex(json, src, 0);
+}
 
-    if (!json || jsean_get_type(src) != JSEAN_TYPE_STRING)
+int jsean_read_stream(jsean *json, FILE *fp)
+{
+    return jsean_read_stream_ex(json, fp, 0);
+}
+
+int jsean_read_ex(jsean *json, jsean *src, unsigned int flags)
+{
+    if (jsean_get_type(src) != JSEAN_TYPE_STRING)
         return JSEAN_INVALID_ARGUMENTS;
 
-    if (!strbuf_init(&p.buf))
+    return read_buffer_with(json, jsean_get_str(src), jsean_str_len(src), flags,
+        default_allocator());
+}
+
+int jsean_read_stream_ex(jsean *json, FILE *fp, unsigned int flags)
+{
+    return read_stream_with(json, fp, flags, default_allocator());
+}
+
+int jsean_read_alloc(jsean *json, jsean *src, unsigned int flags, const jsean_allocator *alloc)
+{
+    if (jsean_get_type(src) != JSEAN_TYPE_STRING || !alloc)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    return read_buffer_with(json, jsean_get_str(src), jsean_str_len(src), flags,
+        alloc);
+}
+
+int jsean_read_stream_alloc(jsean *json, FILE *fp, unsigned int flags, const jsean_allocator *alloc)
+{
+    if (!alloc)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    return read_stream_with(json, fp, flags, alloc);
+}
+
+// Parses the text with @scratch as the scratch buffer, which keeps whatever
+// capacity it grows to, or with a buffer of its own if @scratch is NULL
+static int parse_with(struct parser *p, jsean *json, unsigned int flags,
+    const jsean_allocator *alloc, struct strbuf *scratch)
+{
+    int ret;
+
+    ret = str_alloc_index(alloc);
+    if (ret < 0)
+        return JSEAN_TOO_MANY_ALLOCATORS;
+
+    if (scratch)
+        p->buf = *scratch;
+    else if (!strbuf_init(&p->buf, default_allocator()))
         return JSEAN_OUT_OF_MEMORY;
 
-    p.ptr = jsean_get_str(src);
-    p.end = p.ptr + jsean_str_len(src);
-    p.peek = peek_buffer;
-    p.read = read_buffer;
+    p->flags = flags;
+    p->alloc = alloc;
+    p->s_free = ret;
+    p->validate = false;
 
-    ret = parse_text(&p, json);
+    ret = parse_text(p, json);
+
+    if (scratch) {
+        strbuf_clear(&p->buf);
+        *scratch = p->buf;
+    } else {
+        strbuf_free(&p->buf);
+    }
 
-    strbuf_free(&p.buf);
     return ret;
 }
 
-int jsean_read_stream(jsean *json, FILE *fp)
+static int parse_buffer_with(jsean *json, const char *str, size_t len,
+    unsigned int flags, const jsean_allocator *alloc, struct strbuf *scratch)
 {
     struct parser p;
-    int ret;
 
-    if (!json || !fp)
+    if (!json || !str)
         return JSEAN_INVALID_ARGUMENTS;
 
-    if (!strbuf_init(&p.buf))
-        return JSEAN_OUT_OF_MEMORY;
+    p.ptr = str;
+    p.end = str + len;
+    p.peek = peek_buffer;
+    p.read = read_buffer;
+
+    return parse_with(&p, json, flags, alloc, scratch);
+}
+
+static int parse_stream_with(jsean *json, FILE *fp, unsigned int flags,
+    const jsean_allocator *alloc, struct strbuf *scratch)
+{
+    struct parser p;
+
+    if (!json || !fp)
+        return JSEAN_INVALID_ARGUMENTS;
 
     p.fp = fp;
     p.peek = peek_stream;
     p.read = read_stream;
 
-    ret = parse_text(&p, json);
+    return parse_with(&p, json, flags, alloc, scratch);
+}
+
+int read_buffer_with(jsean *json, const char *str, size_t len,
+    unsigned int flags, const jsean_allocator *alloc)
+{
+    return parse_buffer_with(json, str, len, flags, alloc, NULL);
+}
+
+int read_stream_with(jsean *json, FILE *fp, unsigned int flags,
+    const jsean_allocator *alloc)
+{
+    return parse_stream_with(json, fp, flags, alloc, NULL);
+}
+
+int validate_buffer(const char *str, size_t len)
+{
+    struct parser p;
+    jsean json;
+    int ret;
+
+    if (!str)
+        return JSEAN_INVALID_ARGUMENTS;
 
+    if (!strbuf_init(&p.buf, default_allocator()))
+        return JSEAN_OUT_OF_MEMORY;
+
+    p.ptr = str;
+    p.end = str + len;
+    p.peek = peek_buffer;
+    p.read = read_buffer;
+    p.flags = 0;
+    p.alloc = default_allocator();
+    p.s_free = STRING_FREE_DEFAULT;
+    p.validate = true;
+
+    ret = parse_text(&p, &json);
     strbuf_free(&p.buf);
+
     return ret;
 }
+
+struct jsean_parser {
+    struct strbuf buf;
+    unsigned int flags;
+    const jsean_allocator *alloc;
+};
+
+jsean_parser *jsean_parser_new(unsigned int flags, const jsean_allocator *alloc)
+{
+    const jsean_allocator *self = default_allocator();
+    jsean_parser *parser;
+
+    parser = mem_alloc(self, sizeof(*parser));
+    if (!parser)
+        return NULL;
+
+    if (!strbuf_init(&parser->buf, self)) {
+        mem_free(self, parser, sizeof(*parser));
+        return NULL;
+    }
+
+    parser->flags = flags;
+    parser->alloc = alloc;
+
+    return parser;
+}
+
+void jsean_parser_reset(jsean_parser *parser, unsigned int flags,
+    const jsean_allocator *alloc)
+{
+    if (!parser)
+        return;
+
+    strbuf_clear(&parser->buf);
+    parser->flags = flags;
+    parser->alloc = alloc;
+}
+
+void jsean_parser_free(jsean_parser *parser)
+{
+    const jsean_allocator *self;
+
+    if (!parser)
+        return;
+
+    // The parser was allocated with the same allocator as its buffer
+    self = parser->buf.alloc;
+    strbuf_free(&parser->buf);
+    mem_free(self, parser, sizeof(*parser));
+}
+
+int jsean_parser_read(jsean_parser *parser, jsean *json, jsean *src)
+{
+    if (!parser || jsean_get_type(src) != JSEAN_TYPE_STRING)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    return parse_buffer_with(json, jsean_get_str(src), jsean_str_len(src),
+        parser->flags, parser->alloc ? parser->alloc : default_allocator(),
+        &parser->buf);
+}
+
+int jsean_parser_read_stream(jsean_parser *parser, jsean *json, FILE *fp)
+{
+    if (!parser)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    return parse_stream_with(json, fp, parser->flags,
+        parser->alloc ? parser->alloc : default_allocator(), &parser->buf);
+}
@@ -4,13 +4,96 @@
 // Licensed under the BSD 2-Clause License. See LICENSE.txt
 //
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdlib.h>
 
 #include "jsean.h"
 #include "jsean_internal.h"
 
+typedef void (*free_fn_t)(void *);
+
+// Shared by all strings. Entries are only ever added, so a string's index
+// stays valid for the lifetime of the program.
+static _Atomic(free_fn_t) free_fns[STRING_FREE_ALLOC] = {
+    [STRING_FREE_NONE] = NULL,
+    [STRING_FREE_DEFAULT] = free,
+};
+
+// Allocators that strings have been read with, in the same way
+static _Atomic(const jsean_allocator *) allocs[STRING_FREE_MAX - STRING_FREE_ALLOC];
+
+int free_fn_index(void (*fn)(void *))
+{
+    free_fn_t cur;
+
+    if (!fn)
+        return STRING_FREE_NONE;
+
+    if (fn == free)
+        return STRING_FREE_DEFAULT;
+
+    for (int i = STRING_FREE_DEFAULT + 1; i < STRING_FREE_ALLOC; i++) {
+        cur = atomic_load_explicit(&free_fns[i], memory_order_acquire);
+
+        if (!cur) {
+            // Another thread may claim the entry first, possibly for the
+            // same function
+            atomic_compare_exchange_strong(&free_fns[i], &cur, fn);
+            if (!cur)
+                return i;
+        }
+
+        if (cur == fn)
+            return i;
+    }
+
+    return -1;
+}
+
+int str_alloc_index(const jsean_allocator *alloc)
+{
+    const jsean_allocator *cur;
+    const int n = STRING_FREE_MAX - STRING_FREE_ALLOC;
+
+    if (alloc == &heap_allocator)
+        return STRING_FREE_DEFAULT;
+
+    if (is_arena(alloc))
+        return STRING_FREE_NONE;
+
+    for (int i = 0; i < n; i++) {
+        cur = atomic_load_explicit(&allocs[i], memory_order_acquire);
+
+        if (!cur) {
+            atomic_compare_exchange_strong(&allocs[i], &cur, alloc);
+            if (!cur)
+                return STRING_FREE_ALLOC + i;
+        }
+
+        if (cur == alloc)
+            return STRING_FREE_ALLOC + i;
+    }
+
+    return -1;
+}
+
+bool str_from_alloc(const jsean *json, const jsean_allocator *alloc)
+{
+    if (json->s_free == STRING_FREE_DEFAULT)
+        return alloc == &heap_allocator;
+
+    if (json->s_free < STRING_FREE_ALLOC)
+        return false;
+
+    return alloc == atomic_load_explicit(&allocs[json->s_free - STRING_FREE_ALLOC],
+        memory_order_relaxed);
+}
+
 int jsean_set_str(jsean *json, char *str, size_t len, void (*free_fn)(void *))
 {
+    int idx;
+
     if (!json || !str || len > STRING_LENGTH_MAX)
         return JSEAN_INVALID_ARGUMENTS;
 
@@ -21,9 +104,15 @@ int jsean_set_str(jsean *json, char *str, size_t len, void (*free_fn)(void *))
             return JSEAN_INVALID_ARGUMENTS;
     }
 
+    idx = free_fn_index(free_fn);
+    if (idx < 0)
+        return JSEAN_TOO_MANY_FREE_FUNCTIONS;
+
     json->s_val = str;
     json->s_len = len;
-    json->s_free_fn = free_fn;
+    json->s_free = idx;
+    json->s_small = 0;
+    json->s_known = 0;
     json->type = JSEAN_TYPE_STRING;
 
     return JSEAN_SUCCESS;
@@ -32,17 +121,31 @@ int jsean_set_str(jsean *json, char *str, size_t len, void (*free_fn)(void *))
 const char *jsean_get_str(const jsean *json)
 {
     if (json && json->type == JSEAN_TYPE_STRING)
-        return json->s_val;
+        return str_ptr(json);
 
     return NULL;
 }
 
 size_t jsean_str_len(const jsean *json)
 {
-    if (!json || !json->s_val || json->type != JSEAN_TYPE_STRING)
+    if (!json || json->type != JSEAN_TYPE_STRING)
+        return 0;
+
+    if (!json->s_small && !json->s_val)
         return 0;
 
-    return json->s_len;
+    return str_len(json);
+}
+
+unsigned int jsean_str_flags(jsean *json)
+{
+    if (!json || json->type != JSEAN_TYPE_STRING)
+        return 0;
+
+    if (!json->s_known)
+        str_set_flags(json, str_scan(str_ptr(json), jsean_str_len(json)));
+
+    return (json->s_escape ? JSEAN_STR_ESCAPE : 0) | (json->s_ascii ? JSEAN_STR_ASCII : 0);
 }
 
 bool str_cmp(const jsean *json, const jsean *other)
@@ -56,29 +159,49 @@ bool str_cmp(const jsean *json, const jsean *other)
     if (jsean_str_len(json) != jsean_str_len(other))
         return false;
 
-    return memcmp(json->s_val, other->s_val, jsean_str_len(json)) == 0;
+    return memcmp(str_ptr(json), str_ptr(other), jsean_str_len(json)) == 0;
 }
 
-// Hashes the string with djb2, http://www.cse.yorku.ca/~oz/hash.html
 size_t str_hash(const jsean *json)
 {
-    size_t hash;
-
     if (!json || json->type != JSEAN_TYPE_STRING)
         return STRING_HASH_UNDEFINED;
 
-    hash = 638130537;
-    for (size_t i = 0; i < jsean_str_len(json); i++)
-        hash = ((hash << 5) + hash) + json->s_val[i];
+    return __jsean_hash(str_ptr(json), jsean_str_len(json));
+}
 
-    if (hash == STRING_HASH_UNDEFINED)
-        hash++;
+int jsean_key_init(jsean_key *key, const char *str, size_t len)
+{
+    if (!key || !str || len > STRING_LENGTH_MAX)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (!len) {
+        len = strlen(str);
+
+        if (len > STRING_LENGTH_MAX)
+            return JSEAN_INVALID_ARGUMENTS;
+    }
+
+    key->k_val = str;
+    key->k_len = len;
+    key->k_hash = __jsean_hash(str, len);
 
-    return hash;
+    return JSEAN_SUCCESS;
 }
 
 void str_free(jsean *json)
 {
-    if (json && json->s_val && json->s_free_fn)
-        json->s_free_fn(json->s_val);
+    const jsean_allocator *alloc;
+
+    if (!json || json->s_small || !json->s_val || json->s_free == STRING_FREE_NONE)
+        return;
+
+    if (json->s_free < STRING_FREE_ALLOC) {
+        atomic_load_explicit(&free_fns[json->s_free], memory_order_relaxed)(json->s_val);
+        return;
+    }
+
+    alloc = atomic_load_explicit(&allocs[json->s_free - STRING_FREE_ALLOC],
+        memory_order_relaxed);
+    mem_free(alloc, json->s_val, json->s_len);
 }
@@ -4,49 +4,254 @@
 // Licensed under the BSD 2-Clause License. See LICENSE.txt
 //
 
+#include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "jsean.h"
 #include "jsean_internal.h"
 
-#define NUM_BUF_LEN 64
+// Bytes that can always be written after reserve(), without checking again
+#define WRITER_RESERVE_MAX 64
+
+#define TRY_RESERVE(writer, n)          \
+    do {                                \
+        if (!reserve((writer), (n)))    \
+            return false;               \
+    } while (0)
 
-#define TRY_WRITE(writer, byte)                  \
-    do {                                         \
-        bool ret;                                \
-        ret = (writer)->write((writer), (byte)); \
-        if (!ret)                                \
-            return false;                        \
+#define TRY_WRITE(writer, byte)         \
+    do {                                \
+        TRY_RESERVE(writer, 1);         \
+        *(writer)->ptr++ = (byte);      \
     } while (0)
 
-#define TRY_WRITE_LITERAL(writer, str)           \
-    do {                                         \
-        for (size_t i = 0; i < strlen(str); i++) \
-            TRY_WRITE(writer, (str)[i]);         \
+#define TRY_WRITE_BYTES(writer, str, len)                \
+    do {                                                 \
+        if (!write_bytes((writer), (str), (len)))        \
+            return false;                                \
     } while (0)
 
+#define TRY_WRITE_LITERAL(writer, str) \
+    TRY_WRITE_BYTES(writer, str, sizeof(str) - 1)
+
+// Output goes straight into the buffer between @ptr and @end. Only when it
+// runs out is @refill called, which makes room for @n more bytes, or for as
+// many as fit, which is at least WRITER_RESERVE_MAX.
 struct writer {
-    char n_buf[NUM_BUF_LEN];
-    struct strbuf buf;
+    char *ptr;
+    char *end;
     const char *indent;
+    size_t indent_len;
+    unsigned int flags;
+    struct strbuf buf;
+
+    // Where the buffer is flushed to, when streaming
+    jsean_sink sink;
+    void *ctx;
+
+    bool (*refill)(struct writer *, size_t n);
+};
+
+static inline bool reserve(struct writer *wr, size_t n)
+{
+    if ((size_t)(wr->end - wr->ptr) >= n)
+        return true;
+
+    return wr->refill(wr, n);
+}
+
+static bool write_bytes(struct writer *wr, const char *str, size_t len)
+{
+    size_t n;
+
+    while ((size_t)(wr->end - wr->ptr) < len) {
+        n = wr->end - wr->ptr;
+        memcpy(wr->ptr, str, n);
+        wr->ptr += n;
+        str += n;
+        len -= n;
+
+        if (!wr->refill(wr, len))
+            return false;
+    }
+
+    memcpy(wr->ptr, str, len);
+    wr->ptr += len;
+
+    return true;
+}
+
+// Grows the string buffer
+static bool refill_strbuf(struct writer *wr, size_t n)
+{
+    wr->buf.len = wr->ptr - wr->buf.data;
+    if (!strbuf_reserve(&wr->buf, n))
+        return false;
+
+    wr->ptr = wr->buf.data + wr->buf.len;
+    wr->end = wr->buf.data + wr->buf.cap;
+
+    return true;
+}
+
+// Hands the buffer to the sink, and starts over from the beginning. Large
+// writes are split by write_bytes(), so the buffer only needs to fit @n bytes
+// for reserve().
+static bool refill_sink(struct writer *wr, size_t n)
+{
+    (void)n;
 
-    bool (*write)(struct writer *, char);
+    if (wr->ptr > wr->buf.data && !wr->sink(wr->ctx, wr->buf.data, wr->ptr - wr->buf.data))
+        return false;
+
+    wr->ptr = wr->buf.data;
+
+    return true;
+}
+
+// A buffer of fixed size can't be refilled
+static bool refill_none(struct writer *wr, size_t n)
+{
+    (void)wr;
+    (void)n;
+
+    return false;
+}
+
+// Output as a list of pieces. Text is written into chunks owned by the list,
+// and long runs of text that need no escaping are pointed to where they are.
+struct iov_chunk {
+    struct iov_chunk *next;
+    size_t size;
+    char data[];
+};
+
+struct jsean_iov {
+    struct writer wr;
+
+    // Start of the text in the newest chunk that isn't in the list yet
+    char *mark;
+
+    struct iovec *vec;
+    size_t count;
+    size_t cap;
+    size_t len;
+    struct iov_chunk *chunks;
 };
 
-static bool __write(struct writer *wr, char byte)
+static bool iov_push(struct jsean_iov *iov, const char *base, size_t len)
 {
-    return strbuf_add_byte(&wr->buf, byte);
+    struct iovec *vec;
+    size_t cap;
+
+    if (len == 0)
+        return true;
+
+    if (iov->count == iov->cap) {
+        cap = iov->cap ? iov->cap * 2 : 16;
+        vec = mem_realloc(&heap_allocator, iov->vec, iov->cap * sizeof(*vec),
+            cap * sizeof(*vec));
+        if (!vec)
+            return false;
+
+        iov->vec = vec;
+        iov->cap = cap;
+    }
+
+    iov->vec[iov->count].iov_base = (void *)base;
+    iov->vec[iov->count].iov_len = len;
+    iov->count++;
+    iov->len += len;
+
+    return true;
 }
 
+// Adds the text written since the last time to the list
+static bool iov_cut(struct jsean_iov *iov)
+{
+    if (!iov_push(iov, iov->mark, iov->wr.ptr - iov->mark))
+        return false;
+
+    iov->mark = iov->wr.ptr;
+
+    return true;
+}
+
+// Starts a new chunk, once the text in the old one is in the list. The
+// writer is the first member of the list, so the list can be found from it.
+static bool refill_iov(struct writer *wr, size_t n)
+{
+    struct jsean_iov *iov = (struct jsean_iov *)wr;
+    struct iov_chunk *chunk;
+    size_t size;
+
+    if (iov->chunks && !iov_cut(iov))
+        return false;
+
+    size = n > WRITE_IOV_CHUNK_SIZE ? n : WRITE_IOV_CHUNK_SIZE;
+    chunk = mem_alloc(&heap_allocator, sizeof(*chunk) + size);
+    if (!chunk)
+        return false;
+
+    chunk->next = iov->chunks;
+    chunk->size = size;
+    iov->chunks = chunk;
+
+    wr->ptr = iov->mark = chunk->data;
+    wr->end = chunk->data + size;
+
+    return true;
+}
+
+// Writes text that needs no escaping. In a list, long text is pointed to
+// instead of copied.
+static bool write_ref(struct writer *wr, const char *str, size_t len)
+{
+    struct jsean_iov *iov;
+
+    if (wr->refill != refill_iov || len < WRITE_IOV_REF_MIN)
+        return write_bytes(wr, str, len);
+
+    iov = (struct jsean_iov *)wr;
+
+    return iov_cut(iov) && iov_push(iov, str, len);
+}
+
+static bool write_number(struct writer *wr, double num);
 static bool write_string(struct writer *wr, const char *str, size_t len);
 static bool write_value(struct writer *wr, const jsean *json);
 
+// Writes the indentation, the key and the value of the member in slot @i
+static bool write_member(struct writer *wr, const struct obj *obj, size_t i)
+{
+    if (wr->indent) {
+        TRY_WRITE(wr, '\n');
+        TRY_WRITE_BYTES(wr, wr->indent, wr->indent_len);
+    }
+
+    if (!write_string(wr, key_str(&obj->keys[i]), obj->keys[i].len))
+        return false;
+    TRY_WRITE(wr, ':');
+    if (wr->indent)
+        TRY_WRITE(wr, ' ');
+
+    return write_value(wr, &obj_vals(obj)[i]);
+}
+
 static bool write_object(struct writer *wr, const jsean *json)
 {
     struct obj *obj;
-    struct obj_pair *ptr;
-    size_t len;
+    size_t i, len;
 
     TRY_WRITE(wr, '{');
 
@@ -54,41 +259,17 @@ static bool write_object(struct writer *wr, const jsean *json)
         obj = json->ao_ptr;
         len = obj->len;
 
-        for (ptr = obj->ptr; len > 1; ptr++) {
-            if (jsean_get_type(&ptr->key) != JSEAN_TYPE_STRING)
+        for (i = 0; len > 0; i++) {
+            if (!key_is_live(&obj->keys[i]))
                 continue;
 
-            if (wr->indent) {
-                TRY_WRITE(wr, '\n');
-                TRY_WRITE_LITERAL(wr, wr->indent);
-            }
-
-            write_value(wr, &ptr->key);
-            TRY_WRITE(wr, ':');
-            if (wr->indent)
-                TRY_WRITE(wr, ' ');
+            if (!write_member(wr, obj, i))
+                return false;
 
-            write_value(wr, &ptr->val);
-            TRY_WRITE(wr, ',');
-
-            len--;
+            if (--len > 0)
+                TRY_WRITE(wr, ',');
         }
 
-        if (wr->indent) {
-            TRY_WRITE(wr, '\n');
-            TRY_WRITE_LITERAL(wr, wr->indent);
-        }
-
-        while (jsean_get_type(&ptr->key) != JSEAN_TYPE_STRING)
-            ptr++;
-
-        write_value(wr, &ptr->key);
-        TRY_WRITE(wr, ':');
-        if (wr->indent)
-            TRY_WRITE(wr, ' ');
-
-        write_value(wr, &ptr->val);
-
         if (wr->indent)
             TRY_WRITE(wr, '\n');
     }
@@ -98,27 +279,44 @@ static bool write_object(struct writer *wr, const jsean *json)
     return true;
 }
 
+// Packed arrays are written as they are, without unpacking them
+static bool write_element(struct writer *wr, const struct arr *arr, size_t i)
+{
+    if (arr->packed)
+        return write_number(wr, arr_nums(arr)[i]);
+
+    return write_value(wr, &arr->vals[i]);
+}
+
 static bool write_array(struct writer *wr, const jsean *json)
 {
+    const struct arr *arr;
+    size_t len;
+
     TRY_WRITE(wr, '[');
 
-    if (jsean_arr_len(json) > 0) {
-        for (size_t i = 0; i < jsean_arr_len(json) - 1; i++) {
+    len = jsean_arr_len(json);
+    if (len > 0) {
+        arr = json->ao_ptr;
+
+        for (size_t i = 0; i < len - 1; i++) {
             if (wr->indent) {
                 TRY_WRITE(wr, '\n');
-                TRY_WRITE_LITERAL(wr, wr->indent);
+                TRY_WRITE_BYTES(wr, wr->indent, wr->indent_len);
             }
 
-            write_value(wr, jsean_arr_at(json, i));
+            if (!write_element(wr, arr, i))
+                return false;
             TRY_WRITE(wr, ',');
         }
 
         if (wr->indent) {
             TRY_WRITE(wr, '\n');
-            TRY_WRITE_LITERAL(wr, wr->indent);
+            TRY_WRITE_BYTES(wr, wr->indent, wr->indent_len);
         }
 
-        write_value(wr, jsean_arr_at(json, jsean_arr_len(json) - 1));
+        if (!write_element(wr, arr, len - 1))
+            return false;
 
         if (wr->indent)
             TRY_WRITE(wr, '\n');
@@ -129,95 +327,214 @@ static bool write_array(struct writer *wr, const jsean *json)
     return true;
 }
 
-// Trims trailing zeroes, and uses exponential notation for large numbers.
 static bool write_number(struct writer *wr, double num)
 {
-    int idx, idx2, len;
+    char tmp[NUM_FORMAT_MAX];
 
-    if (num != 0.0 && (num > 1e21 || num < 1e-7))
-        idx = snprintf(wr->n_buf, NUM_BUF_LEN, "%e", num);
+    // Near the end of the buffer, the number may still fit exactly
+    if (!reserve(wr, NUM_FORMAT_MAX))
+        TRY_WRITE_BYTES(wr, tmp, num_format(num, tmp));
     else
-        idx = snprintf(wr->n_buf, NUM_BUF_LEN, "%f", num);
+        wr->ptr += num_format(num, wr->ptr);
 
-    if (num != 0.0 && (num > 1e21 || num < 1e-7)) {
-        idx2 = idx;
+    return true;
+}
 
-        while (wr->n_buf[idx - 1] != 'e')
-            idx--;
-        idx--;
+// For each byte, what follows the backslash if it has to be escaped, or 0
+static const char escapes[256] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    ['"'] = '"',
+    ['\\'] = '\\',
+};
 
-        len = idx2 - idx;
-        idx2 = idx;
+static const char hex_digits[16] = "0123456789abcdef";
 
-        while (wr->n_buf[idx - 1] == '0')
-            idx--;
-        if (wr->n_buf[idx - 1] == '.')
-            idx--;
+// Returns the index of the first byte from @i on that has to be escaped, or
+// @len if there are none. With @ascii, bytes above 0x7f count as well.
+static inline size_t find_escape(const unsigned char *p, size_t i, size_t len,
+    bool ascii)
+{
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    __m128i v, hit;
+    unsigned int mask;
+
+    for (; i + 16 <= len; i += 16) {
+        v = _mm_loadu_si128((const __m128i *)(p + i));
+
+        // Unsigned v <= 0x1f is the same as min(v, 0x1f) == v
+        hit = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+
+        mask = _mm_movemask_epi8(hit);
+        if (ascii)
+            mask |= _mm_movemask_epi8(v);
+
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+#else
+#define ONES  0x0101010101010101ull
+#define HIGHS 0x8080808080808080ull
+    uint64_t x, hit;
+
+    // Sets the high bit of some byte if any byte is zero, or less than 0x20
+    // for the last one. The byte found isn't exact, so the loop below finds it.
+    for (; i + 8 <= len; i += 8) {
+        memcpy(&x, p + i, 8);
+
+        hit = (x - ONES * 0x20) & ~x;
+        hit |= ((x ^ ONES * '"') - ONES) & ~(x ^ ONES * '"');
+        hit |= ((x ^ ONES * '\\') - ONES) & ~(x ^ ONES * '\\');
+        if (ascii)
+            hit |= x;
+
+        if (hit & HIGHS)
+            break;
+    }
+#undef ONES
+#undef HIGHS
+#endif
+
+    for (; i < len; i++) {
+        if (escapes[p[i]] || (ascii && p[i] > 0x7f))
+            break;
+    }
+
+    return i;
+}
 
-        memcpy(&wr->n_buf[idx], &wr->n_buf[idx2], len);
-        wr->n_buf[idx + len] = '\0';
+// Returns the code point of the UTF-8 sequence at the start of @p, and its
+// length in @n. Anything invalid is read as U+FFFD, one byte at a time.
+static unsigned int decode_utf8(const unsigned char *p, size_t len, size_t *n)
+{
+    unsigned int cp, min;
+    size_t i;
+
+    if (p[0] >= 0xf0 && p[0] <= 0xf4) {
+        cp = p[0] & 0x07;
+        *n = 4;
+        min = 0x10000;
+    } else if (p[0] >= 0xe0) {
+        cp = p[0] & 0x0f;
+        *n = 3;
+        min = 0x800;
+    } else if (p[0] >= 0xc2 && p[0] <= 0xdf) {
+        cp = p[0] & 0x1f;
+        *n = 2;
+        min = 0x80;
     } else {
-        while (wr->n_buf[idx - 1] == '0')
-            idx--;
-        if (wr->n_buf[idx - 1] == '.')
-            idx--;
+        goto invalid;
+    }
+
+    if (*n > len || p[0] > 0xf4)
+        goto invalid;
 
-        wr->n_buf[idx] = '\0';
+    for (i = 1; i < *n; i++) {
+        if ((p[i] & 0xc0) != 0x80)
+            goto invalid;
+
+        cp = (cp << 6) | (p[i] & 0x3f);
     }
 
-    TRY_WRITE_LITERAL(wr, wr->n_buf);
+    if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+        goto invalid;
 
-    return true;
+    return cp;
+
+invalid:
+    *n = 1;
+    return 0xfffd;
+}
+
+// Writes "\uXXXX" into @out, which must have room for 6 bytes
+static inline void put_unicode_escape(char *out, unsigned int cp)
+{
+    out[0] = '\\';
+    out[1] = 'u';
+    out[2] = hex_digits[(cp >> 12) & 0xf];
+    out[3] = hex_digits[(cp >> 8) & 0xf];
+    out[4] = hex_digits[(cp >> 4) & 0xf];
+    out[5] = hex_digits[cp & 0xf];
+}
+
+// Length of the string once quoted and escaped
+static size_t size_string(const char *str, size_t len, bool ascii)
+{
+    const unsigned char *p = (const unsigned char *)str;
+    size_t i, n, size = len + 2;
+    unsigned int cp;
+
+    for (i = find_escape(p, 0, len, ascii); i < len; i = find_escape(p, i + n, len, ascii)) {
+        n = 1;
+
+        // Only with JSEAN_WRITE_ASCII, as in write_string()
+        if (p[i] > 0x7f) {
+            cp = decode_utf8(p + i, len - i, &n);
+            size += (cp > 0xffff ? 12 : 6) - n;
+            continue;
+        }
+
+        size += escapes[p[i]] == 'u' ? 5 : 1;
+    }
+
+    return size;
 }
 
+// Runs of bytes that need no escaping are found a block at a time, and
+// copied at once
 static bool write_string(struct writer *wr, const char *str, size_t len)
 {
+    const unsigned char *p = (const unsigned char *)str;
+    bool ascii = wr->flags & JSEAN_WRITE_ASCII;
+    unsigned int cp;
+    size_t i, run, n;
+    char esc;
+
     TRY_WRITE(wr, '\"');
 
-    for (size_t i = 0; i < len; i++) {
-        switch (str[i]) {
-        case 0x00: TRY_WRITE_LITERAL(wr, "\\u0000"); break;
-        case 0x01: TRY_WRITE_LITERAL(wr, "\\u0001"); break;
-        case 0x02: TRY_WRITE_LITERAL(wr, "\\u0002"); break;
-        case 0x03: TRY_WRITE_LITERAL(wr, "\\u0003"); break;
-        case 0x04: TRY_WRITE_LITERAL(wr, "\\u0004"); break;
-        case 0x05: TRY_WRITE_LITERAL(wr, "\\u0005"); break;
-        case 0x06: TRY_WRITE_LITERAL(wr, "\\u0006"); break;
-        case 0x07: TRY_WRITE_LITERAL(wr, "\\u0007"); break;
-        case 0x08: TRY_WRITE_LITERAL(wr, "\\b"); break;
-        case 0x09: TRY_WRITE_LITERAL(wr, "\\t"); break;
-        case 0x0a: TRY_WRITE_LITERAL(wr, "\\n"); break;
-        case 0x0b: TRY_WRITE_LITERAL(wr, "\\u000b"); break;
-        case 0x0c: TRY_WRITE_LITERAL(wr, "\\f"); break;
-        case 0x0d: TRY_WRITE_LITERAL(wr, "\\r"); break;
-        case 0x0e: TRY_WRITE_LITERAL(wr, "\\u000e"); break;
-        case 0x0f: TRY_WRITE_LITERAL(wr, "\\u000f"); break;
-
-        case 0x10: TRY_WRITE_LITERAL(wr, "\\u0010"); break;
-        case 0x11: TRY_WRITE_LITERAL(wr, "\\u0011"); break;
-        case 0x12: TRY_WRITE_LITERAL(wr, "\\u0012"); break;
-        case 0x13: TRY_WRITE_LITERAL(wr, "\\u0013"); break;
-        case 0x14: TRY_WRITE_LITERAL(wr, "\\u0014"); break;
-        case 0x15: TRY_WRITE_LITERAL(wr, "\\u0015"); break;
-        case 0x16: TRY_WRITE_LITERAL(wr, "\\u0016"); break;
-        case 0x17: TRY_WRITE_LITERAL(wr, "\\u0017"); break;
-        case 0x18: TRY_WRITE_LITERAL(wr, "\\u0018"); break;
-        case 0x19: TRY_WRITE_LITERAL(wr, "\\u0019"); break;
-        case 0x1a: TRY_WRITE_LITERAL(wr, "\\u001a"); break;
-        case 0x1b: TRY_WRITE_LITERAL(wr, "\\u001b"); break;
-        case 0x1c: TRY_WRITE_LITERAL(wr, "\\u001c"); break;
-        case 0x1d: TRY_WRITE_LITERAL(wr, "\\u001d"); break;
-        case 0x1e: TRY_WRITE_LITERAL(wr, "\\u001e"); break;
-        case 0x1f: TRY_WRITE_LITERAL(wr, "\\u001f"); break;
-
-        case 0x22: TRY_WRITE_LITERAL(wr, "\\\""); break;
-
-        case 0x5c: TRY_WRITE_LITERAL(wr, "\\\\"); break;
-
-        default:
-            TRY_WRITE(wr, str[i]);
+    for (i = 0; i < len; i = run + n) {
+        run = find_escape(p, i, len, ascii);
+
+        if (!write_ref(wr, str + i, run - i))
+            return false;
+        if (run == len)
+            break;
+
+        n = 1;
+
+        // Only with JSEAN_WRITE_ASCII. Code points above U+FFFF take a
+        // surrogate pair.
+        if (p[run] > 0x7f) {
+            cp = decode_utf8(p + run, len - run, &n);
+            TRY_RESERVE(wr, cp > 0xffff ? 12 : 6);
+
+            if (cp > 0xffff) {
+                cp -= 0x10000;
+                put_unicode_escape(wr->ptr, 0xd800 + (cp >> 10));
+                wr->ptr += 6;
+                cp = 0xdc00 + (cp & 0x3ff);
+            }
+
+            put_unicode_escape(wr->ptr, cp);
+            wr->ptr += 6;
+            continue;
+        }
+
+        esc = escapes[p[run]];
+        if (esc == 'u') {
+            TRY_RESERVE(wr, 6);
+            put_unicode_escape(wr->ptr, p[run]);
+            wr->ptr += 6;
+            continue;
         }
 
+        TRY_RESERVE(wr, 2);
+        *wr->ptr++ = '\\';
+        *wr->ptr++ = esc;
     }
 
     TRY_WRITE(wr, '\"');
@@ -225,6 +542,43 @@ static bool write_string(struct writer *wr, const char *str, size_t len)
     return true;
 }
 
+// Strings known to need no escaping are copied without looking at them
+static bool write_string_value(struct writer *wr, const jsean *json)
+{
+    bool ascii = wr->flags & JSEAN_WRITE_ASCII;
+
+    if (!json->s_known || json->s_escape || (ascii && !json->s_ascii))
+        return write_string(wr, jsean_get_str(json), jsean_str_len(json));
+
+    TRY_WRITE(wr, '\"');
+    if (!write_ref(wr, jsean_get_str(json), jsean_str_len(json)))
+        return false;
+    TRY_WRITE(wr, '\"');
+
+    return true;
+}
+
+unsigned int str_scan(const char *str, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)str;
+    unsigned int flags = JSEAN_STR_ASCII;
+    size_t i;
+
+    // Once a byte above 0x7f is found, only escapes are left to look for
+    for (i = find_escape(p, 0, len, true); i < len;
+         i = find_escape(p, i + 1, len, flags & JSEAN_STR_ASCII)) {
+        if (p[i] > 0x7f)
+            flags &= ~JSEAN_STR_ASCII;
+        else
+            flags |= JSEAN_STR_ESCAPE;
+
+        if (flags == JSEAN_STR_ESCAPE)
+            break;
+    }
+
+    return flags;
+}
+
 static bool write_value(struct writer *wr, const jsean *json)
 {
     switch (jsean_get_type(json)) {
@@ -249,34 +603,854 @@ static bool write_value(struct writer *wr, const jsean *json)
         return write_number(wr, jsean_get_num(json));
 
     case JSEAN_TYPE_STRING:
-        return write_string(wr, jsean_get_str(json), jsean_str_len(json));
+        return write_string_value(wr, json);
+
+    case JSEAN_TYPE_RAW:
+        return write_ref(wr, json->s_val, json->s_len);
 
     default:
         return false;
     }
 }
 
+static size_t size_value(const jsean *json, const char *indent,
+    size_t indent_len, unsigned int flags);
+
+static size_t size_object(const jsean *json, const char *indent,
+    size_t indent_len, unsigned int flags)
+{
+    const struct obj *obj;
+    size_t i, len, size;
+
+    size = 2;
+
+    if (jsean_obj_len(json) > 0) {
+        obj = json->ao_ptr;
+        len = obj->len;
+
+        // Each member has a colon, and all but the last one a comma
+        size += 2 * len - 1;
+        if (indent)
+            size += (indent_len + 2) * len + 1;
+
+        for (i = 0; i < obj->cap; i++) {
+            if (!key_is_live(&obj->keys[i]))
+                continue;
+
+            size += size_string(key_str(&obj->keys[i]), obj->keys[i].len,
+                flags & JSEAN_WRITE_ASCII);
+            size += size_value(&obj_vals(obj)[i], indent, indent_len, flags);
+        }
+    }
+
+    return size;
+}
+
+static size_t size_array(const jsean *json, const char *indent,
+    size_t indent_len, unsigned int flags)
+{
+    const struct arr *arr;
+    char tmp[NUM_FORMAT_MAX];
+    size_t len, size;
+
+    size = 2;
+
+    len = jsean_arr_len(json);
+    if (len > 0) {
+        arr = json->ao_ptr;
+
+        size += len - 1;
+        if (indent)
+            size += (indent_len + 1) * len + 1;
+
+        for (size_t i = 0; i < len; i++) {
+            if (arr->packed)
+                size += num_format(arr_nums(arr)[i], tmp);
+            else
+                size += size_value(&arr->vals[i], indent, indent_len, flags);
+        }
+    }
+
+    return size;
+}
+
+static size_t size_value(const jsean *json, const char *indent,
+    size_t indent_len, unsigned int flags)
+{
+    bool ascii = flags & JSEAN_WRITE_ASCII;
+    char tmp[NUM_FORMAT_MAX];
+
+    switch (jsean_get_type(json)) {
+    case JSEAN_TYPE_NULL:
+        return 4;
+
+    case JSEAN_TYPE_BOOLEAN:
+        return jsean_get_bool(json) ? 4 : 5;
+
+    case JSEAN_TYPE_OBJECT:
+        return size_object(json, indent, indent_len, flags);
+
+    case JSEAN_TYPE_ARRAY:
+        return size_array(json, indent, indent_len, flags);
+
+    case JSEAN_TYPE_NUMBER:
+        return num_format(jsean_get_num(json), tmp);
+
+    case JSEAN_TYPE_STRING:
+        if (json->s_known && !json->s_escape && (!ascii || json->s_ascii))
+            return jsean_str_len(json) + 2;
+
+        return size_string(jsean_get_str(json), jsean_str_len(json), ascii);
+
+    case JSEAN_TYPE_RAW:
+        return json->s_len;
+
+    default:
+        return 0;
+    }
+}
+
+size_t jsean_write_size(const jsean *json, const char *indent)
+{
+    return jsean_write_size_ex(json, indent, 0);
+}
+
+size_t jsean_write_size_ex(const jsean *json, const char *indent,
+    unsigned int flags)
+{
+    if (!json)
+        return 0;
+
+    return size_value(json, indent, indent ? strlen(indent) : 0, flags);
+}
+
+size_t jsean_write_to(const jsean *json, char *buf, size_t cap, const char *indent)
+{
+    return jsean_write_to_ex(json, buf, cap, indent, 0);
+}
+
+size_t jsean_write_to_ex(const jsean *json, char *buf, size_t cap,
+    const char *indent, unsigned int flags)
+{
+    struct writer wr;
+
+    if (!json || !buf)
+        return 0;
+
+    wr.ptr = buf;
+    wr.end = buf + cap;
+    wr.indent = indent;
+    wr.indent_len = indent ? strlen(indent) : 0;
+    wr.flags = flags;
+    wr.refill = refill_none;
+
+    if (!write_value(&wr, json))
+        return 0;
+
+    return wr.ptr - buf;
+}
+
 char *jsean_write(const jsean *json, size_t *len, const char *indent)
+{
+    return jsean_write_ex(json, len, indent, 0);
+}
+
+// Finding out the size first would take formatting every number twice,
+// which costs more than growing the buffer
+char *jsean_write_ex(const jsean *json, size_t *len, const char *indent,
+    unsigned int flags)
 {
     struct writer wr;
 
     if (!json)
         return NULL;
 
-    if (!strbuf_init(&wr.buf))
+    if (!strbuf_init(&wr.buf, &heap_allocator))
         return NULL;
 
+    wr.ptr = wr.buf.data;
+    wr.end = wr.buf.data + wr.buf.cap;
     wr.indent = indent;
-    wr.write = __write;
+    wr.indent_len = indent ? strlen(indent) : 0;
+    wr.flags = flags;
+    wr.refill = refill_strbuf;
 
-    if (!write_value(&wr, json))
+    if (!write_value(&wr, json) || !reserve(&wr, 1)) {
+        strbuf_free(&wr.buf);
         return NULL;
+    }
 
+    *wr.ptr = '\0';
     if (len)
-        *len = wr.buf.len;
+        *len = wr.ptr - wr.buf.data;
+
+    return wr.buf.data;
+}
+
+// A range of elements, or of slots in an object, written by one thread.
+// Every element is written with the comma before it, and the first one is
+// dropped when the pieces are put together.
+struct write_job {
+    const jsean *json;
+    size_t begin;
+    size_t end;
+    struct writer wr;
+    bool ok;
+};
+
+static bool write_range(struct writer *wr, const jsean *json, size_t begin,
+    size_t end)
+{
+    const struct arr *arr;
+    const struct obj *obj;
+
+    if (jsean_get_type(json) == JSEAN_TYPE_ARRAY) {
+        arr = json->ao_ptr;
+
+        for (size_t i = begin; i < end; i++) {
+            TRY_WRITE(wr, ',');
+
+            if (wr->indent) {
+                TRY_WRITE(wr, '\n');
+                TRY_WRITE_BYTES(wr, wr->indent, wr->indent_len);
+            }
+
+            if (!write_element(wr, arr, i))
+                return false;
+        }
 
-    if (!strbuf_add_byte(&wr.buf, '\0'))
+        return true;
+    }
+
+    obj = json->ao_ptr;
+
+    for (size_t i = begin; i < end; i++) {
+        if (!key_is_live(&obj->keys[i]))
+            continue;
+
+        TRY_WRITE(wr, ',');
+        if (!write_member(wr, obj, i))
+            return false;
+    }
+
+    return true;
+}
+
+static void *write_job_run(void *arg)
+{
+    struct write_job *job = arg;
+
+    job->ok = write_range(&job->wr, job->json, job->begin, job->end);
+    job->wr.buf.len = job->wr.ptr - job->wr.buf.data;
+
+    return NULL;
+}
+
+// Resizes the buffer to exactly @cap bytes, for output that won't grow again
+static bool resize_exact(struct strbuf *buf, size_t cap)
+{
+    char *data;
+
+    data = mem_realloc(buf->alloc, buf->data, buf->cap, cap);
+    if (!data)
         return false;
 
-    return wr.buf.data;
+    buf->data = data;
+    buf->cap = cap;
+
+    return true;
+}
+
+// Puts the pieces together between the brackets. The first piece with text
+// in it takes the others, each of which is freed once it is copied, so that
+// no more than about the size of the output is held at once. The buffer is
+// taken out of its job.
+static char *write_join(const jsean *json, struct write_job *jobs, size_t n,
+    size_t *len, const char *indent)
+{
+    bool object = jsean_get_type(json) == JSEAN_TYPE_OBJECT;
+    struct strbuf *buf, *next;
+    size_t i;
+    char *str;
+
+    // At least one job wrote something, since the container isn't empty
+    for (i = 0; jobs[i].wr.buf.len == 0; i++)
+        ;
+    buf = &jobs[i].wr.buf;
+
+    // Only the first comma goes, and the bracket takes its place
+    buf->data[0] = object ? '{' : '[';
+
+    // With room for a newline, the closing bracket and the null terminator
+    for (i++; i < n; i++) {
+        next = &jobs[i].wr.buf;
+
+        if (buf->cap - buf->len < next->len + 3 && !resize_exact(buf, buf->len + next->len + 3))
+            return NULL;
+
+        memcpy(buf->data + buf->len, next->data, next->len);
+        buf->len += next->len;
+
+        strbuf_free(next);
+        next->data = NULL;
+    }
+
+    if (buf->cap - buf->len < 3 && !resize_exact(buf, buf->len + 3))
+        return NULL;
+
+    if (indent)
+        buf->data[buf->len++] = '\n';
+    buf->data[buf->len++] = object ? '}' : ']';
+    buf->data[buf->len] = '\0';
+
+    if (len)
+        *len = buf->len;
+
+    str = buf->data;
+    buf->data = NULL;
+
+    return str;
+}
+
+char *jsean_write_parallel(const jsean *json, size_t *len, const char *indent,
+    unsigned int flags, unsigned int threads)
+{
+    struct write_job *jobs;
+    pthread_t *tids;
+    bool *started;
+    size_t count, n, step, size;
+    char *str = NULL;
+    long online;
+
+    if (!json)
+        return NULL;
+
+    if (threads == 0) {
+        online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? online : 1;
+    }
+
+    // Slots of an object are split, since members can't be found by index
+    switch (jsean_get_type(json)) {
+    case JSEAN_TYPE_ARRAY:
+        count = jsean_arr_len(json);
+        n = count / WRITE_PARALLEL_MIN;
+        break;
+
+    case JSEAN_TYPE_OBJECT:
+        count = jsean_obj_len(json) > 0 ? ((struct obj *)json->ao_ptr)->cap : 0;
+        n = jsean_obj_len(json) / WRITE_PARALLEL_MIN;
+        break;
+
+    default:
+        n = 0;
+        break;
+    }
+
+    if (n > threads)
+        n = threads;
+
+    if (n < 2)
+        return jsean_write_ex(json, len, indent, flags);
+
+    size = n * (sizeof(*jobs) + sizeof(*tids) + sizeof(*started));
+    jobs = mem_alloc(&heap_allocator, size);
+    if (!jobs)
+        return NULL;
+    tids = (pthread_t *)&jobs[n];
+    started = (bool *)&tids[n];
+
+    step = (count + n - 1) / n;
+    for (size_t i = 0; i < n; i++) {
+        jobs[i].json = json;
+        jobs[i].begin = i * step;
+        jobs[i].end = i * step + step < count ? i * step + step : count;
+        jobs[i].wr.indent = indent;
+        jobs[i].wr.indent_len = indent ? strlen(indent) : 0;
+        jobs[i].wr.flags = flags;
+        jobs[i].wr.refill = refill_strbuf;
+        jobs[i].ok = false;
+        started[i] = false;
+
+        if (!strbuf_init(&jobs[i].wr.buf, &heap_allocator)) {
+            n = i;
+            goto out;
+        }
+
+        jobs[i].wr.ptr = jobs[i].wr.buf.data;
+        jobs[i].wr.end = jobs[i].wr.buf.data + jobs[i].wr.buf.cap;
+    }
+
+    // The calling thread takes the first range, and any that couldn't get a
+    // thread of their own
+    for (size_t i = 1; i < n; i++)
+        started[i] = pthread_create(&tids[i], NULL, write_job_run, &jobs[i]) == 0;
+
+    write_job_run(&jobs[0]);
+    for (size_t i = 1; i < n; i++) {
+        if (started[i])
+            pthread_join(tids[i], NULL);
+        else
+            write_job_run(&jobs[i]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (!jobs[i].ok)
+            goto out;
+    }
+
+    str = write_join(json, jobs, n, len, indent);
+
+out:
+    for (size_t i = 0; i < n; i++)
+        strbuf_free(&jobs[i].wr.buf);
+    mem_free(&heap_allocator, jobs, size);
+
+    return str;
+}
+
+void jsean_iov_free(jsean_iov *iov)
+{
+    struct iov_chunk *chunk, *next;
+
+    if (!iov)
+        return;
+
+    for (chunk = iov->chunks; chunk; chunk = next) {
+        next = chunk->next;
+        mem_free(&heap_allocator, chunk, sizeof(*chunk) + chunk->size);
+    }
+
+    mem_free(&heap_allocator, iov->vec, iov->cap * sizeof(*iov->vec));
+    mem_free(&heap_allocator, iov, sizeof(*iov));
+}
+
+jsean_iov *jsean_write_iov(const jsean *json, const char *indent,
+    unsigned int flags)
+{
+    jsean_iov *iov;
+
+    if (!json)
+        return NULL;
+
+    iov = mem_alloc(&heap_allocator, sizeof(*iov));
+    if (!iov)
+        return NULL;
+
+    iov->vec = NULL;
+    iov->count = 0;
+    iov->cap = 0;
+    iov->len = 0;
+    iov->chunks = NULL;
+
+    iov->wr.indent = indent;
+    iov->wr.indent_len = indent ? strlen(indent) : 0;
+    iov->wr.flags = flags;
+    iov->wr.refill = refill_iov;
+
+    if (!refill_iov(&iov->wr, 0) || !write_value(&iov->wr, json) || !iov_cut(iov)) {
+        jsean_iov_free(iov);
+        return NULL;
+    }
+
+    return iov;
+}
+
+const struct iovec *jsean_iov_vec(const jsean_iov *iov, size_t *count)
+{
+    if (!iov) {
+        if (count)
+            *count = 0;
+        return NULL;
+    }
+
+    if (count)
+        *count = iov->count;
+
+    return iov->vec;
+}
+
+size_t jsean_iov_len(const jsean_iov *iov)
+{
+    return iov ? iov->len : 0;
+}
+
+static bool sink_file(void *ctx, const char *data, size_t len)
+{
+    return fwrite(data, 1, len, ctx) == len;
+}
+
+int jsean_write_stream(const jsean *json, FILE *fp, const char *indent)
+{
+    return jsean_write_stream_ex(json, fp, indent, 0);
+}
+
+int jsean_write_stream_ex(const jsean *json, FILE *fp, const char *indent,
+    unsigned int flags)
+{
+    if (!fp)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    return jsean_write_cb_ex(json, sink_file, fp, indent, flags);
+}
+
+int jsean_write_cb(const jsean *json, jsean_sink sink, void *ctx, const char *indent)
+{
+    return jsean_write_cb_ex(json, sink, ctx, indent, 0);
+}
+
+int jsean_write_cb_ex(const jsean *json, jsean_sink sink, void *ctx,
+    const char *indent, unsigned int flags)
+{
+    struct writer wr;
+    bool ok;
+
+    if (!json || !sink)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (!strbuf_init(&wr.buf, &heap_allocator))
+        return JSEAN_OUT_OF_MEMORY;
+
+    if (!strbuf_reserve(&wr.buf, WRITE_STREAM_BUFFER_SIZE)) {
+        strbuf_free(&wr.buf);
+        return JSEAN_OUT_OF_MEMORY;
+    }
+
+    wr.ptr = wr.buf.data;
+    wr.end = wr.buf.data + wr.buf.cap;
+    wr.indent = indent;
+    wr.indent_len = indent ? strlen(indent) : 0;
+    wr.flags = flags;
+    wr.sink = sink;
+    wr.ctx = ctx;
+    wr.refill = refill_sink;
+
+    // Only the sink can fail, the buffer is never grown
+    ok = write_value(&wr, json) && refill_sink(&wr, 0);
+    strbuf_free(&wr.buf);
+
+    return ok ? JSEAN_SUCCESS : JSEAN_WRITE_FAILED;
+}
+
+// Each open array or object has a byte on the stack
+#define GEN_OBJECT      (1 << 0)
+#define GEN_NON_EMPTY   (1 << 1)
+
+struct jsean_gen {
+    struct writer wr;
+    struct strbuf stack;
+
+    // A key was written, and its value comes next
+    bool key;
+
+    // The top-level value is complete
+    bool done;
+
+    // Once writing fails, or the generator has finished, every call returns
+    // this
+    int status;
+};
+
+static int gen_fail(jsean_gen *gen)
+{
+    gen->status = gen->wr.sink ? JSEAN_WRITE_FAILED : JSEAN_OUT_OF_MEMORY;
+    return gen->status;
+}
+
+// Writes the comma and the indentation before an element or a member
+static bool gen_separate(jsean_gen *gen, char *top)
+{
+    if (*top & GEN_NON_EMPTY)
+        TRY_WRITE(&gen->wr, ',');
+    *top |= GEN_NON_EMPTY;
+
+    if (gen->wr.indent) {
+        TRY_WRITE(&gen->wr, '\n');
+        TRY_WRITE_BYTES(&gen->wr, gen->wr.indent, gen->wr.indent_len);
+    }
+
+    return true;
+}
+
+// Checks that a value may come next, and writes what goes before it
+static int gen_before_value(jsean_gen *gen)
+{
+    char *top;
+
+    if (gen->status != JSEAN_SUCCESS)
+        return gen->status;
+
+    if (gen->done)
+        return JSEAN_INVALID_NESTING;
+
+    if (gen->stack.len == 0)
+        return JSEAN_SUCCESS;
+
+    top = &gen->stack.data[gen->stack.len - 1];
+
+    // Members are separated before their keys
+    if (*top & GEN_OBJECT) {
+        if (!gen->key)
+            return JSEAN_INVALID_NESTING;
+
+        gen->key = false;
+        return JSEAN_SUCCESS;
+    }
+
+    if (!gen_separate(gen, top))
+        return gen_fail(gen);
+
+    return JSEAN_SUCCESS;
+}
+
+static int gen_after_value(jsean_gen *gen)
+{
+    if (gen->stack.len == 0)
+        gen->done = true;
+
+    return JSEAN_SUCCESS;
+}
+
+jsean_gen *jsean_gen_new(jsean_sink sink, void *ctx, const char *indent,
+    unsigned int flags)
+{
+    jsean_gen *gen;
+
+    gen = mem_alloc(&heap_allocator, sizeof(*gen));
+    if (!gen)
+        return NULL;
+
+    if (!strbuf_init(&gen->wr.buf, &heap_allocator))
+        goto err_gen;
+
+    if (sink && !strbuf_reserve(&gen->wr.buf, WRITE_STREAM_BUFFER_SIZE))
+        goto err_buf;
+
+    if (!strbuf_init(&gen->stack, &heap_allocator))
+        goto err_buf;
+
+    gen->wr.ptr = gen->wr.buf.data;
+    gen->wr.end = gen->wr.buf.data + gen->wr.buf.cap;
+    gen->wr.indent = indent;
+    gen->wr.indent_len = indent ? strlen(indent) : 0;
+    gen->wr.flags = flags;
+    gen->wr.sink = sink;
+    gen->wr.ctx = ctx;
+    gen->wr.refill = sink ? refill_sink : refill_strbuf;
+
+    gen->key = false;
+    gen->done = false;
+    gen->status = JSEAN_SUCCESS;
+
+    return gen;
+
+err_buf:
+    strbuf_free(&gen->wr.buf);
+err_gen:
+    mem_free(&heap_allocator, gen, sizeof(*gen));
+    return NULL;
+}
+
+void jsean_gen_free(jsean_gen *gen)
+{
+    if (!gen)
+        return;
+
+    strbuf_free(&gen->wr.buf);
+    strbuf_free(&gen->stack);
+    mem_free(&heap_allocator, gen, sizeof(*gen));
+}
+
+static int gen_begin(jsean_gen *gen, char open, char type)
+{
+    int ret;
+
+    if (!gen)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    ret = gen_before_value(gen);
+    if (ret != JSEAN_SUCCESS)
+        return ret;
+
+    if (!reserve(&gen->wr, 1) || !strbuf_add_byte(&gen->stack, type))
+        return gen_fail(gen);
+
+    *gen->wr.ptr++ = open;
+
+    return JSEAN_SUCCESS;
+}
+
+int jsean_gen_begin_obj(jsean_gen *gen)
+{
+    return gen_begin(gen, '{', GEN_OBJECT);
+}
+
+int jsean_gen_begin_arr(jsean_gen *gen)
+{
+    return gen_begin(gen, '[', 0);
+}
+
+int jsean_gen_end(jsean_gen *gen)
+{
+    char top;
+
+    if (!gen)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (gen->status != JSEAN_SUCCESS)
+        return gen->status;
+
+    if (gen->stack.len == 0 || gen->key)
+        return JSEAN_INVALID_NESTING;
+
+    top = gen->stack.data[--gen->stack.len];
+
+    if (!reserve(&gen->wr, 2))
+        return gen_fail(gen);
+
+    if ((top & GEN_NON_EMPTY) && gen->wr.indent)
+        *gen->wr.ptr++ = '\n';
+    *gen->wr.ptr++ = (top & GEN_OBJECT) ? '}' : ']';
+
+    return gen_after_value(gen);
+}
+
+int jsean_gen_key(jsean_gen *gen, const char *str, size_t len)
+{
+    char *top;
+
+    if (!gen || !str)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (gen->status != JSEAN_SUCCESS)
+        return gen->status;
+
+    if (gen->stack.len == 0 || gen->key)
+        return JSEAN_INVALID_NESTING;
+
+    top = &gen->stack.data[gen->stack.len - 1];
+    if (!(*top & GEN_OBJECT))
+        return JSEAN_INVALID_NESTING;
+
+    if (!len)
+        len = strlen(str);
+
+    if (!gen_separate(gen, top) || !write_string(&gen->wr, str, len)
+        || !reserve(&gen->wr, 2))
+        return gen_fail(gen);
+
+    *gen->wr.ptr++ = ':';
+    if (gen->wr.indent)
+        *gen->wr.ptr++ = ' ';
+
+    gen->key = true;
+
+    return JSEAN_SUCCESS;
+}
+
+int jsean_gen_null(jsean_gen *gen)
+{
+    jsean tmp;
+
+    jsean_set_null(&tmp);
+    return jsean_gen_value(gen, &tmp);
+}
+
+int jsean_gen_bool(jsean_gen *gen, bool b)
+{
+    jsean tmp;
+
+    jsean_set_bool(&tmp, b);
+    return jsean_gen_value(gen, &tmp);
+}
+
+int jsean_gen_num(jsean_gen *gen, double num)
+{
+    int ret;
+
+    if (!gen || !isfinite(num))
+        return JSEAN_INVALID_ARGUMENTS;
+
+    ret = gen_before_value(gen);
+    if (ret != JSEAN_SUCCESS)
+        return ret;
+
+    if (!write_number(&gen->wr, num))
+        return gen_fail(gen);
+
+    return gen_after_value(gen);
+}
+
+int jsean_gen_str(jsean_gen *gen, const char *str, size_t len)
+{
+    int ret;
+
+    if (!gen || !str)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (!len)
+        len = strlen(str);
+
+    ret = gen_before_value(gen);
+    if (ret != JSEAN_SUCCESS)
+        return ret;
+
+    if (!write_string(&gen->wr, str, len))
+        return gen_fail(gen);
+
+    return gen_after_value(gen);
+}
+
+int jsean_gen_value(jsean_gen *gen, const jsean *json)
+{
+    int ret;
+
+    if (!gen || jsean_get_type(json) == JSEAN_TYPE_UNKNOWN)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    ret = gen_before_value(gen);
+    if (ret != JSEAN_SUCCESS)
+        return ret;
+
+    if (!write_value(&gen->wr, json))
+        return gen_fail(gen);
+
+    return gen_after_value(gen);
+}
+
+int jsean_gen_finish(jsean_gen *gen, char **out, size_t *len)
+{
+    if (!gen)
+        return JSEAN_INVALID_ARGUMENTS;
+
+    if (gen->status != JSEAN_SUCCESS)
+        return gen->status;
+
+    if (!gen->done)
+        return JSEAN_INVALID_NESTING;
+
+    if (gen->wr.sink) {
+        if (!refill_sink(&gen->wr, 0))
+            return gen_fail(gen);
+
+        gen->status = JSEAN_INVALID_NESTING;
+        return JSEAN_SUCCESS;
+    }
+
+    if (!reserve(&gen->wr, 1))
+        return gen_fail(gen);
+    *gen->wr.ptr = '\0';
+
+    if (len)
+        *len = gen->wr.ptr - gen->wr.buf.data;
+
+    // The text is handed over, or dropped if nobody wants it
+    if (out) {
+        *out = gen->wr.buf.data;
+        gen->wr.buf.data = NULL;
+        gen->wr.buf.cap = 0;
+    }
+
+    gen->status = JSEAN_INVALID_NESTING;
+    return JSEAN_SUCCESS;
 }
@@ -0,0 +1,244 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsean.h"
+#include "test.h"
+
+struct counter {
+    size_t allocs;
+    size_t frees;
+    size_t bytes;
+};
+
+static void *counting_alloc(void *ctx, size_t size)
+{
+    struct counter *c = ctx;
+
+    c->allocs++;
+    c->bytes += size;
+    return malloc(size);
+}
+
+static void *counting_realloc(void *ctx, void *ptr, size_t old_size, size_t size)
+{
+    struct counter *c = ctx;
+
+    if (!ptr)
+        c->allocs++;
+    c->bytes += size - old_size;
+    return realloc(ptr, size);
+}
+
+static void counting_free(void *ctx, void *ptr, size_t size)
+{
+    struct counter *c = ctx;
+
+    if (!ptr)
+        return;
+
+    c->frees++;
+    c->bytes -= size;
+    free(ptr);
+}
+
+#define COUNTING_ALLOCATOR(c) \
+    { counting_alloc, counting_realloc, counting_free, (c) }
+
+TEST(jsean_allocator, default)
+{
+    struct counter c = {0};
+    const jsean_allocator alloc = COUNTING_ALLOCATOR(&c);
+    jsean json, val;
+
+    ASSERT(jsean_get_allocator() != NULL);
+
+    jsean_set_allocator(&alloc);
+    ASSERT(jsean_get_allocator() == &alloc);
+
+    jsean_set_arr(&json);
+    jsean_set_num(&val, 1);
+    ASSERT(jsean_arr_push(&json, &val) != NULL);
+
+    jsean_set_obj(&val);
+    ASSERT(jsean_obj_set(&val, JSEAN_S("a key longer than eight bytes"), JSEAN_S("x")) != NULL);
+    ASSERT(jsean_arr_push(&json, &val) != NULL);
+    ASSERT(c.allocs > 0);
+
+    jsean_free(&json);
+    ASSERT(c.allocs == c.frees);
+    ASSERT(c.bytes == 0);
+
+    ASSERT(jsean_read(&json, JSEAN_S("{\"key\": [\"a long string value\", {}], \"frozen\": {\"a\": 1, \"b\": 2}}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(jsean_obj_at(&json, JSEAN_S("frozen"))) == JSEAN_SUCCESS);
+    jsean_free(&json);
+    ASSERT(c.allocs == c.frees);
+    ASSERT(c.bytes == 0);
+
+    jsean_set_allocator(NULL);
+    ASSERT(jsean_get_allocator() != &alloc);
+}
+
+TEST(jsean_allocator, read)
+{
+    struct counter c = {0};
+    const jsean_allocator alloc = COUNTING_ALLOCATOR(&c);
+    jsean json, val;
+
+    ASSERT(jsean_read_alloc(&json, JSEAN_S("[]"), 0, NULL) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_read_alloc(&json, JSEAN_S("[1, "), 0, &alloc) != JSEAN_SUCCESS);
+    ASSERT(c.allocs == c.frees);
+
+    ASSERT(jsean_read_alloc(&json, JSEAN_S("{\"a key longer than eight bytes\": [\"a long string value\"], \"b\": {}}"), 0, &alloc) == JSEAN_SUCCESS);
+    ASSERT(c.allocs > 0);
+    ASSERT(memcmp(jsean_get_str(jsean_arr_at(jsean_obj_at(&json, JSEAN_S("a key longer than eight bytes")), 0)), "a long string value", 19) == 0);
+
+    // Empty containers from the parser keep using the same allocator
+    jsean_set_num(&val, 1);
+    ASSERT(jsean_obj_set(jsean_obj_at(&json, JSEAN_S("b")), JSEAN_S("x"), &val) != NULL);
+
+    jsean_free(&json);
+    ASSERT(c.allocs == c.frees);
+    ASSERT(c.bytes == 0);
+}
+
+TEST(jsean_allocator, doc)
+{
+    struct counter c = {0};
+    const jsean_allocator alloc = COUNTING_ALLOCATOR(&c);
+    jsean_doc *doc;
+    jsean json;
+
+    // The arena's chunks come from the default allocator
+    jsean_set_allocator(&alloc);
+    ASSERT(jsean_read_doc(&doc, JSEAN_S("[1, 2, 3]"), 0) == JSEAN_SUCCESS);
+    jsean_set_allocator(NULL);
+    ASSERT(c.allocs > 0);
+
+    // Values read with the document's allocator are freed with it
+    ASSERT(jsean_doc_allocator(NULL) == NULL);
+    ASSERT(jsean_read_alloc(&json, JSEAN_S("[\"a long string value\"]"), 0, jsean_doc_allocator(doc)) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_push(jsean_doc_root(doc), &json) != NULL);
+    ASSERT(jsean_arr_len(jsean_doc_root(doc)) == 4);
+
+    jsean_doc_free(doc);
+    ASSERT(c.allocs == c.frees);
+    ASSERT(c.bytes == 0);
+}
+
+TEST(jsean_allocator, containers)
+{
+    struct counter c = {0};
+    const jsean_allocator alloc = COUNTING_ALLOCATOR(&c);
+    jsean arr, obj, val;
+
+    jsean_set_allocator(&alloc);
+
+    // Arrays and objects are a single block each
+    jsean_set_arr(&arr);
+    jsean_set_num(&val, 1);
+    ASSERT(jsean_arr_push(&arr, &val) != NULL);
+    ASSERT(c.allocs == 1);
+
+    jsean_set_obj(&obj);
+    ASSERT(jsean_obj_set(&obj, JSEAN_S("a"), &val) != NULL);
+    ASSERT(c.allocs == 2);
+
+    // Growing, packing and freezing move the whole container
+    for (int i = 0; i < 100; i++) {
+        jsean_set_num(&val, i);
+        ASSERT(jsean_arr_push(&arr, &val) != NULL);
+    }
+    ASSERT(jsean_arr_pack(&arr) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_num(&arr, 100) == 99.0);
+
+    ASSERT(jsean_obj_set(&obj, JSEAN_S("b"), &arr) != NULL);
+    ASSERT(jsean_freeze(&obj) == JSEAN_SUCCESS);
+    ASSERT(jsean_get_num(jsean_arr_at(jsean_obj_at(&obj, JSEAN_S("b")), 100)) == 99.0);
+
+    jsean_set_allocator(NULL);
+
+    jsean_free(&obj);
+    ASSERT(c.allocs == c.frees);
+    ASSERT(c.bytes == 0);
+}
+
+TEST(jsean_allocator, pool)
+{
+    const jsean_allocator *pool = jsean_pool_allocator();
+    void *a, *b, *c;
+    jsean json;
+
+    // Freed blocks are reused for sizes of the same class
+    a = pool->alloc(pool->ctx, 40);
+    ASSERT(a != NULL);
+    memset(a, 'a', 40);
+    pool->free(pool->ctx, a, 40);
+    b = pool->alloc(pool->ctx, 64);
+    ASSERT(b == a);
+
+    // Growing within the class keeps the block, and past it moves it
+    ASSERT(pool->realloc(pool->ctx, b, 64, 50) == b);
+    memset(b, 'b', 50);
+    c = pool->realloc(pool->ctx, b, 50, 100);
+    ASSERT(c != NULL);
+    ASSERT(memcmp(c, "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb", 50) == 0);
+
+    // Blocks too large for the pool go to malloc()
+    c = pool->realloc(pool->ctx, c, 100, 10000);
+    ASSERT(c != NULL);
+    c = pool->realloc(pool->ctx, c, 10000, 20000);
+    ASSERT(c != NULL);
+    pool->free(pool->ctx, c, 20000);
+    pool->free(pool->ctx, NULL, 0);
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT(jsean_read_alloc(&json, JSEAN_S("{\"a key longer than eight bytes\": [\"a long string value\", 1, 2, {}]}"), 0, pool) == JSEAN_SUCCESS);
+        ASSERT(jsean_arr_len(jsean_obj_at(&json, JSEAN_S("a key longer than eight bytes"))) == 4);
+        jsean_free(&json);
+    }
+
+    // Handing off every block, and taking them back to free them
+    jsean_pool_flush();
+    jsean_pool_trim();
+}
+
+// The table of allocators is never emptied, so this runs after the other
+// tests that add allocators to it
+TEST(jsean_allocator, limit)
+{
+    static jsean_allocator allocs[129];
+    struct counter c = {0};
+    size_t i, n = sizeof(allocs) / sizeof(*allocs);
+    int status = JSEAN_SUCCESS;
+    jsean_doc *doc;
+    jsean json;
+
+    for (i = 0; i < n; i++) {
+        allocs[i] = (jsean_allocator)COUNTING_ALLOCATOR(&c);
+
+        status = jsean_read_alloc(&json, JSEAN_S("[\"a long string value\"]"), 0, &allocs[i]);
+        if (status != JSEAN_SUCCESS)
+            break;
+        jsean_free(&json);
+    }
+
+    // Room for 128 allocators, some of them taken by the other tests
+    ASSERT(status == JSEAN_TOO_MANY_ALLOCATORS);
+    ASSERT(i < 128);
+    ASSERT(c.allocs == c.frees);
+
+    // Allocators already in the table still work, as do the default one and
+    // documents
+    ASSERT(jsean_read_alloc(&json, JSEAN_S("[\"a long string value\"]"), 0, &allocs[0]) == JSEAN_SUCCESS);
+    jsean_free(&json);
+    ASSERT(jsean_read(&json, JSEAN_S("[\"a long string value\"]")) == JSEAN_SUCCESS);
+    jsean_free(&json);
+    ASSERT(jsean_read_doc(&doc, JSEAN_S("[\"a long string value\"]"), 0) == JSEAN_SUCCESS);
+    jsean_doc_free(doc);
+}
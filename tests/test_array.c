@@ -6,6 +6,8 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "jsean.h"
 #include "test.h"
@@ -198,3 +200,213 @@ TEST(jsean_array, clear)
     jsean_free(&a);
     jsean_free(&b);
 }
+
+TEST(jsean_array, reserve)
+{
+    jsean a, b, *ptr;
+
+    jsean_set_null(&b);
+    ASSERT(jsean_arr_reserve(&b, 10) != JSEAN_SUCCESS);
+
+    jsean_set_arr(&a);
+    ASSERT(jsean_arr_reserve(&a, 100) == JSEAN_SUCCESS);
+
+    jsean_set_num(&b, 0);
+    ptr = jsean_arr_push(&a, &b);
+    for (int i = 1; i < 100; i++) {
+        jsean_set_num(&b, i);
+        jsean_arr_push(&a, &b);
+    }
+
+    // Nothing was reallocated
+    ASSERT(jsean_arr_at(&a, 0) == ptr);
+    ASSERT(jsean_arr_len(&a) == 100);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 99)) == 99);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_array, shrink_to_fit)
+{
+    jsean a, b;
+
+    jsean_set_arr(&a);
+    ASSERT(jsean_arr_shrink_to_fit(&a) == JSEAN_SUCCESS);
+
+    ASSERT(jsean_arr_reserve(&a, 100) == JSEAN_SUCCESS);
+    jsean_set_num(&b, 1);
+    jsean_arr_push(&a, &b);
+    jsean_arr_push(&a, &b);
+
+    ASSERT(jsean_arr_shrink_to_fit(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_len(&a) == 2);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 1)) == 1);
+
+    jsean_arr_clear(&a);
+    ASSERT(jsean_arr_shrink_to_fit(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_push(&a, &b) != NULL);
+    ASSERT(jsean_arr_push(&a, &b) != NULL);
+    ASSERT(jsean_arr_len(&a) == 2);
+
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_shrink_to_fit(&a) == JSEAN_FROZEN);
+    ASSERT(jsean_arr_reserve(&a, 10) == JSEAN_FROZEN);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_array, splice)
+{
+    jsean a, vals[4];
+
+    ASSERT(jsean_arr_splice(NULL, 0, 0, NULL, 0) == JSEAN_INVALID_ARGUMENTS);
+
+    jsean_set_arr(&a);
+    ASSERT(jsean_arr_splice(&a, 0, 0, NULL, 0) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_splice(&a, 1, 0, NULL, 0) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_arr_splice(&a, 0, 0, NULL, 1) == JSEAN_INVALID_ARGUMENTS);
+
+    for (int i = 0; i < 4; i++)
+        jsean_set_num(&vals[i], i);
+    ASSERT(jsean_arr_splice(&a, 0, 0, vals, 4) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_len(&a) == 4);
+
+    // [0, 1, 2, 3] -> [0, 10, 3]
+    jsean_set_num(&vals[0], 10.0);
+    ASSERT(jsean_arr_splice(&a, 1, 2, vals, 1) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_len(&a) == 3);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 0)) == 0.0);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 1)) == 10.0);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 2)) == 3.0);
+
+    // [0, 10, 3] -> [0, 20, 21, 22, 3]
+    for (int i = 0; i < 3; i++)
+        jsean_set_num(&vals[i], 20 + i);
+    ASSERT(jsean_arr_splice(&a, 1, 1, vals, 3) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_len(&a) == 5);
+    for (int i = 0; i < 3; i++)
+        ASSERT(jsean_get_num(jsean_arr_at(&a, i + 1)) == 20 + i);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 4)) == 3.0);
+
+    ASSERT(jsean_arr_splice(&a, 4, 2, NULL, 0) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_arr_splice(&a, 6, 0, NULL, 0) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_arr_len(&a) == 5);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_array, extend)
+{
+    jsean a, vals[100];
+
+    jsean_set_arr(&a);
+    for (size_t round = 0; round < 3; round++) {
+        for (int i = 0; i < 100; i++)
+            jsean_set_str(&vals[i], "abc", 3, NULL);
+        ASSERT(jsean_arr_extend(&a, vals, 100) == JSEAN_SUCCESS);
+        ASSERT(jsean_arr_len(&a) == (round + 1) * 100);
+    }
+
+    ASSERT(jsean_arr_extend(&a, NULL, 0) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_len(&a) == 300);
+
+    jsean_set_bool(&vals[0], true);
+    jsean_freeze(&a);
+    ASSERT(jsean_arr_extend(&a, vals, 1) == JSEAN_FROZEN);
+    ASSERT(jsean_arr_len(&a) == 300);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_array, del_range)
+{
+    jsean a, b;
+
+    jsean_set_arr(&a);
+    for (int i = 0; i < 10; i++) {
+        jsean_set_str(&b, strdup("abc"), 3, free);
+        jsean_arr_push(&a, &b);
+    }
+
+    ASSERT(jsean_arr_del_range(&a, 2, 5) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_len(&a) == 5);
+    ASSERT(jsean_arr_del_range(&a, 0, 0) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_del_range(&a, 4, 2) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_arr_del_range(&a, 0, 5) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_len(&a) == 0);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_array, pack)
+{
+    jsean a, b;
+    double *nums;
+    size_t len;
+
+    ASSERT(jsean_arr_pack(NULL) == JSEAN_INVALID_ARGUMENTS);
+
+    jsean_set_arr(&a);
+    ASSERT(jsean_arr_pack(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_num_data(&a, NULL) == NULL);
+
+    for (int i = 0; i < 20; i++) {
+        jsean_set_num(&b, i);
+        jsean_arr_push(&a, &b);
+    }
+
+    ASSERT(jsean_arr_num_data(&a, NULL) == NULL);
+    ASSERT(jsean_arr_pack(&a) == JSEAN_SUCCESS);
+
+    nums = jsean_arr_num_data(&a, &len);
+    ASSERT(nums != NULL);
+    ASSERT(len == 20);
+    for (size_t i = 0; i < len; i++)
+        ASSERT(nums[i] == (double)i);
+
+    // Deleting keeps the array packed
+    ASSERT(jsean_arr_del_range(&a, 0, 10) == JSEAN_SUCCESS);
+    nums = jsean_arr_num_data(&a, &len);
+    ASSERT(nums != NULL);
+    ASSERT(len == 10);
+    ASSERT(nums[0] == 10.0);
+
+    // Reading doesn't unpack it, and there are no values to point to
+    ASSERT(jsean_arr_num(&a, 9) == 19.0);
+    ASSERT(jsean_arr_num(&a, 10) == 0.0);
+    ASSERT(jsean_arr_at(&a, 9) == NULL);
+    ASSERT(jsean_arr_num_data(&a, NULL) != NULL);
+
+    ASSERT(jsean_arr_unpack(NULL) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_arr_unpack(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_unpack(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 9)) == 19.0);
+    ASSERT(jsean_arr_at(&a, 9)->s_free == 0);
+    ASSERT(jsean_arr_at(&a, 9)->s_known == 0);
+    ASSERT(jsean_arr_num(&a, 9) == 19.0);
+    ASSERT(jsean_arr_num_data(&a, NULL) == NULL);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 0)) == 10.0);
+
+    jsean_set_null(&b);
+    jsean_arr_push(&a, &b);
+    ASSERT(jsean_arr_pack(&a) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_arr_len(&a) == 11);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_array, pack_freeze)
+{
+    jsean a;
+
+    ASSERT(jsean_read(&a, JSEAN_S("[1, 2, 3]")) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_pack(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_num_data(&a, NULL) != NULL);
+
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_num_data(&a, NULL) == NULL);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 2)) == 3.0);
+    ASSERT(jsean_arr_pack(&a) == JSEAN_FROZEN);
+
+    jsean_free(&a);
+}
@@ -0,0 +1,112 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsean.h"
+#include "test.h"
+
+TEST(jsean_doc, read)
+{
+    jsean_doc *doc;
+    jsean *root;
+
+    ASSERT(jsean_read_doc(NULL, JSEAN_S("[]"), 0) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_read_doc(&doc, NULL, 0) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_read_doc(&doc, JSEAN_S("[1, "), 0) != JSEAN_SUCCESS);
+
+    ASSERT(jsean_read_doc(&doc, JSEAN_S("{\"a\": [1, \"a long string value\"], \"b\": {}, \"c\": []}"), 0) == JSEAN_SUCCESS);
+
+    root = jsean_doc_root(doc);
+    ASSERT(jsean_get_type(root) == JSEAN_TYPE_OBJECT);
+    ASSERT(jsean_obj_len(root) == 3);
+    ASSERT(jsean_arr_len(jsean_obj_at(root, JSEAN_S("a"))) == 2);
+    ASSERT(memcmp(jsean_get_str(jsean_arr_at(jsean_obj_at(root, JSEAN_S("a")), 1)), "a long string value", 19) == 0);
+    ASSERT(jsean_obj_len(jsean_obj_at(root, JSEAN_S("b"))) == 0);
+    ASSERT(jsean_arr_len(jsean_obj_at(root, JSEAN_S("c"))) == 0);
+
+    jsean_doc_free(doc);
+    jsean_doc_free(NULL);
+}
+
+TEST(jsean_doc, modify)
+{
+    jsean_doc *doc;
+    jsean *root, *arr, a, b;
+
+    ASSERT(jsean_read_doc(&doc, JSEAN_S("{\"arr\": [], \"obj\": {\"x\": 1}}"), 0) == JSEAN_SUCCESS);
+    root = jsean_doc_root(doc);
+
+    // Grow containers that live in the arena
+    arr = jsean_obj_at(root, JSEAN_S("arr"));
+    for (int i = 0; i < 100; i++) {
+        jsean_set_num(&a, i);
+        ASSERT(jsean_arr_push(arr, &a) != NULL);
+    }
+    ASSERT(jsean_arr_len(arr) == 100);
+    ASSERT(jsean_get_num(jsean_arr_at(arr, 99)) == 99.0);
+
+    // Values from the heap are freed with the document
+    jsean_set_str(&a, strdup("a string from the heap"), 0, free);
+    ASSERT(jsean_arr_push(arr, &a) != NULL);
+
+    jsean_set_arr(&a);
+    jsean_set_str(&b, strdup("another one"), 0, free);
+    jsean_arr_push(&a, &b);
+    ASSERT(jsean_obj_set(jsean_obj_at(root, JSEAN_S("obj")), JSEAN_S("heap"), &a) != NULL);
+
+    jsean_set_str(&a, strdup("a key from the heap"), 0, free);
+    jsean_set_null(&b);
+    ASSERT(jsean_obj_set(root, &a, &b) != NULL);
+
+    jsean_obj_del(root, JSEAN_S("obj"));
+    ASSERT(jsean_obj_len(root) == 2);
+
+    jsean_doc_free(doc);
+}
+
+TEST(jsean_doc, freeze)
+{
+    jsean_doc *doc;
+    jsean *root;
+
+    ASSERT(jsean_read_doc(&doc, JSEAN_S("{\"a\": {\"b\": [1, 2]}, \"c\": [], \"d\": {}}"), 0) == JSEAN_SUCCESS);
+    root = jsean_doc_root(doc);
+
+    ASSERT(jsean_freeze(root) == JSEAN_SUCCESS);
+    ASSERT(jsean_get_num(jsean_arr_at(jsean_obj_at(jsean_obj_at(root, JSEAN_S("a")), JSEAN_S("b")), 1)) == 2.0);
+    ASSERT(jsean_obj_at(root, JSEAN_S("d")) != NULL);
+
+    jsean_doc_free(doc);
+}
+
+TEST(jsean_doc, file_1mb)
+{
+    jsean_doc *doc;
+    jsean a;
+    char *buf, *buf2;
+    FILE *fp;
+
+    fp = fopen(SAMPLES_DIR "/1MB.json", "r");
+    ASSERT(fp != NULL);
+    ASSERT(jsean_read_stream(&a, fp) == JSEAN_SUCCESS);
+
+    rewind(fp);
+    ASSERT(jsean_read_doc_stream(&doc, fp, 0) == JSEAN_SUCCESS);
+    fclose(fp);
+
+    buf = jsean_write(&a, NULL, NULL);
+    buf2 = jsean_write(jsean_doc_root(doc), NULL, NULL);
+    ASSERT(buf != NULL && buf2 != NULL);
+    ASSERT(strcmp(buf, buf2) == 0);
+
+    free(buf);
+    free(buf2);
+    jsean_free(&a);
+    jsean_doc_free(doc);
+}
@@ -0,0 +1,242 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "jsean.h"
+#include "test.h"
+
+#define KEYS 1000
+
+TEST(jsean_freeze, scalar)
+{
+    jsean a;
+
+    ASSERT(jsean_freeze(NULL) != JSEAN_SUCCESS);
+
+    jsean_set_num(&a, 1.0);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_is_frozen(&a) == false);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, empty)
+{
+    jsean a, b;
+
+    jsean_set_obj(&a);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_is_frozen(&a));
+    ASSERT(jsean_obj_at(&a, JSEAN_S("a")) == NULL);
+
+    jsean_set_null(&b);
+    ASSERT(jsean_obj_add(&a, JSEAN_S("a"), &b) == NULL);
+    ASSERT(jsean_obj_len(&a) == 0);
+
+    jsean_free(&a);
+
+    jsean_set_arr(&a);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_is_frozen(&a));
+    ASSERT(jsean_arr_push(&a, &b) == NULL);
+    ASSERT(jsean_arr_len(&a) == 0);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, object)
+{
+    char keys[KEYS][8];
+    jsean a, b, key;
+
+    jsean_set_obj(&a);
+    for (int i = 0; i < KEYS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "k%d", i);
+        jsean_set_str(&key, keys[i], 0, NULL);
+        jsean_set_num(&b, i);
+        ASSERT(jsean_obj_add(&a, &key, &b) != NULL);
+    }
+
+    jsean_obj_del(&a, JSEAN_S("k0"));
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_is_frozen(&a));
+    ASSERT(jsean_obj_len(&a) == KEYS - 1);
+
+    ASSERT(jsean_obj_at(&a, JSEAN_S("k0")) == NULL);
+    ASSERT(jsean_obj_at(&a, JSEAN_S("missing")) == NULL);
+    for (int i = 1; i < KEYS; i++) {
+        jsean_set_str(&key, keys[i], 0, NULL);
+        ASSERT(jsean_get_num(jsean_obj_at(&a, &key)) == i);
+    }
+
+    jsean_set_null(&b);
+    ASSERT(jsean_obj_add(&a, JSEAN_S("new"), &b) == NULL);
+    ASSERT(jsean_obj_set(&a, JSEAN_S("k1"), &b) == NULL);
+    jsean_obj_del(&a, JSEAN_S("k1"));
+    jsean_obj_clear(&a);
+    ASSERT(jsean_obj_len(&a) == KEYS - 1);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("k1"))) == 1);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, nested)
+{
+    jsean a, b;
+
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\":[1,{\"b\":2}],\"c\":\"d\"}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+
+    ASSERT(jsean_is_frozen(jsean_obj_at(&a, JSEAN_S("a"))));
+    ASSERT(jsean_is_frozen(jsean_arr_at(jsean_obj_at(&a, JSEAN_S("a")), 1)));
+    ASSERT(jsean_get_num(jsean_obj_at(jsean_arr_at(jsean_obj_at(&a, JSEAN_S("a")), 1), JSEAN_S("b"))) == 2);
+
+    jsean_set_null(&b);
+    ASSERT(jsean_arr_set(jsean_obj_at(&a, JSEAN_S("a")), 0, &b) == NULL);
+    jsean_arr_del(jsean_obj_at(&a, JSEAN_S("a")), 0);
+    ASSERT(jsean_arr_len(jsean_obj_at(&a, JSEAN_S("a"))) == 2);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, obj_add)
+{
+    jsean a, b;
+
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\":1}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+
+    jsean_set_null(&b);
+    ASSERT(jsean_obj_add(&a, JSEAN_S("b"), &b) == NULL);
+    ASSERT(jsean_obj_len(&a) == 1);
+    ASSERT(jsean_obj_at(&a, JSEAN_S("b")) == NULL);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, obj_set)
+{
+    jsean a, b;
+
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\":1}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+
+    jsean_set_null(&b);
+    ASSERT(jsean_obj_set(&a, JSEAN_S("a"), &b) == NULL);
+    ASSERT(jsean_obj_set(&a, JSEAN_S("b"), &b) == NULL);
+    ASSERT(jsean_obj_len(&a) == 1);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("a"))) == 1);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, obj_entry)
+{
+    jsean a;
+    bool found = true;
+
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\":1}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+
+    ASSERT(jsean_obj_entry(&a, JSEAN_S("a"), &found) == NULL);
+    ASSERT(jsean_obj_entry(&a, JSEAN_S("b"), &found) == NULL);
+    ASSERT(jsean_obj_len(&a) == 1);
+    ASSERT(jsean_obj_at(&a, JSEAN_S("b")) == NULL);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, obj_del)
+{
+    jsean a;
+
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\":1}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+
+    jsean_obj_del(&a, JSEAN_S("a"));
+    ASSERT(jsean_obj_len(&a) == 1);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("a"))) == 1);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, obj_clear)
+{
+    jsean a;
+
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\":1}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+
+    jsean_obj_clear(&a);
+    ASSERT(jsean_obj_len(&a) == 1);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("a"))) == 1);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, arr_add)
+{
+    jsean a, b;
+
+    ASSERT(jsean_read(&a, JSEAN_S("[1]")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+
+    jsean_set_null(&b);
+    ASSERT(jsean_arr_add(&a, 0, &b) == NULL);
+    ASSERT(jsean_arr_add(&a, 1, &b) == NULL);
+    ASSERT(jsean_arr_len(&a) == 1);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 0)) == 1);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, arr_set)
+{
+    jsean a, b;
+
+    ASSERT(jsean_read(&a, JSEAN_S("[1]")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+
+    jsean_set_null(&b);
+    ASSERT(jsean_arr_set(&a, 0, &b) == NULL);
+    ASSERT(jsean_arr_set(&a, 1, &b) == NULL);
+    ASSERT(jsean_arr_len(&a) == 1);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 0)) == 1);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, arr_del)
+{
+    jsean a;
+
+    ASSERT(jsean_read(&a, JSEAN_S("[1]")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+
+    jsean_arr_del(&a, 0);
+    ASSERT(jsean_arr_len(&a) == 1);
+    ASSERT(jsean_arr_del_range(&a, 0, 1) == JSEAN_FROZEN);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 0)) == 1);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_freeze, arr_clear)
+{
+    jsean a;
+
+    ASSERT(jsean_read(&a, JSEAN_S("[1]")) == JSEAN_SUCCESS);
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+
+    jsean_arr_clear(&a);
+    ASSERT(jsean_arr_len(&a) == 1);
+    ASSERT(jsean_get_num(jsean_arr_at(&a, 0)) == 1);
+
+    jsean_free(&a);
+}
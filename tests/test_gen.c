@@ -0,0 +1,192 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsean.h"
+#include "test.h"
+
+// Writes the same values as the text below. Objects have one member each,
+// since jsean_write() doesn't keep the order of members.
+static void generate(jsean_gen *gen)
+{
+    jsean val;
+
+    jsean_read(&val, JSEAN_S("{\"x\": [1, \"y\"]}"));
+
+    jsean_gen_begin_arr(gen);
+    jsean_gen_begin_obj(gen);
+    jsean_gen_key(gen, "a", 0);
+    jsean_gen_begin_arr(gen);
+    jsean_gen_num(gen, 1);
+    jsean_gen_num(gen, 2.5);
+    jsean_gen_str(gen, "a \"quoted\" string\n", 0);
+    jsean_gen_begin_arr(gen);
+    jsean_gen_end(gen);
+    jsean_gen_begin_obj(gen);
+    jsean_gen_end(gen);
+    jsean_gen_end(gen);
+    jsean_gen_end(gen);
+    jsean_gen_null(gen);
+    jsean_gen_bool(gen, true);
+    jsean_gen_value(gen, &val);
+    jsean_gen_end(gen);
+
+    jsean_free(&val);
+}
+
+#define GENERATED "[{\"a\": [1, 2.5, \"a \\\"quoted\\\" string\\n\", [], {}]}, null, true, {\"x\": [1, \"y\"]}]"
+
+TEST(jsean_gen, same_as_write)
+{
+    const char *indents[] = {NULL, "", "  "};
+    jsean_gen *gen;
+    size_t len, expected_len;
+    char *out, *expected;
+    jsean a;
+
+    ASSERT(jsean_read(&a, JSEAN_S(GENERATED)) == JSEAN_SUCCESS);
+
+    for (size_t i = 0; i < sizeof(indents) / sizeof(*indents); i++) {
+        gen = jsean_gen_new(NULL, NULL, indents[i], 0);
+        ASSERT(gen != NULL);
+
+        ASSERT(jsean_gen_begin_obj(gen) == JSEAN_SUCCESS);
+        jsean_gen_free(gen);
+
+        gen = jsean_gen_new(NULL, NULL, indents[i], 0);
+        ASSERT(gen != NULL);
+
+        // Finishing too early fails, but does not stop the generator
+        ASSERT(jsean_gen_finish(gen, &out, NULL) == JSEAN_INVALID_NESTING);
+        generate(gen);
+        ASSERT(jsean_gen_finish(gen, &out, &len) == JSEAN_SUCCESS);
+        ASSERT(jsean_gen_finish(gen, &out, &len) == JSEAN_INVALID_NESTING);
+        jsean_gen_free(gen);
+
+        expected = jsean_write(&a, &expected_len, indents[i]);
+        ASSERT(expected != NULL);
+        ASSERT(len == expected_len);
+        ASSERT(strcmp(out, expected) == 0);
+
+        free(expected);
+        free(out);
+    }
+
+    jsean_free(&a);
+}
+
+TEST(jsean_gen, nesting)
+{
+    jsean_gen *gen;
+    char *out;
+
+    ASSERT(jsean_gen_begin_obj(NULL) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_gen_finish(NULL, NULL, NULL) == JSEAN_INVALID_ARGUMENTS);
+    jsean_gen_free(NULL);
+
+    gen = jsean_gen_new(NULL, NULL, NULL, 0);
+    ASSERT(gen != NULL);
+
+    ASSERT(jsean_gen_end(gen) == JSEAN_INVALID_NESTING);
+    ASSERT(jsean_gen_key(gen, "a", 0) == JSEAN_INVALID_NESTING);
+    ASSERT(jsean_gen_num(gen, NAN) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_gen_value(gen, NULL) == JSEAN_INVALID_ARGUMENTS);
+
+    ASSERT(jsean_gen_begin_arr(gen) == JSEAN_SUCCESS);
+    ASSERT(jsean_gen_key(gen, "a", 0) == JSEAN_INVALID_NESTING);
+    ASSERT(jsean_gen_begin_obj(gen) == JSEAN_SUCCESS);
+
+    // Values in objects need keys, and keys need values
+    ASSERT(jsean_gen_num(gen, 1) == JSEAN_INVALID_NESTING);
+    ASSERT(jsean_gen_key(gen, "a", 0) == JSEAN_SUCCESS);
+    ASSERT(jsean_gen_key(gen, "b", 0) == JSEAN_INVALID_NESTING);
+    ASSERT(jsean_gen_end(gen) == JSEAN_INVALID_NESTING);
+    ASSERT(jsean_gen_num(gen, 1) == JSEAN_SUCCESS);
+    ASSERT(jsean_gen_end(gen) == JSEAN_SUCCESS);
+
+    ASSERT(jsean_gen_str(gen, "", 0) == JSEAN_SUCCESS);
+    ASSERT(jsean_gen_end(gen) == JSEAN_SUCCESS);
+
+    // Only one top-level value
+    ASSERT(jsean_gen_num(gen, 1) == JSEAN_INVALID_NESTING);
+    ASSERT(jsean_gen_begin_arr(gen) == JSEAN_INVALID_NESTING);
+    ASSERT(jsean_gen_end(gen) == JSEAN_INVALID_NESTING);
+
+    ASSERT(jsean_gen_finish(gen, &out, NULL) == JSEAN_SUCCESS);
+    ASSERT(strcmp(out, "[{\"a\":1},\"\"]") == 0);
+
+    free(out);
+    jsean_gen_free(gen);
+}
+
+struct sink {
+    char *data;
+    size_t len;
+    size_t calls;
+    bool fail;
+};
+
+static bool collect(void *ctx, const char *data, size_t len)
+{
+    struct sink *sink = ctx;
+
+    if (sink->fail)
+        return false;
+
+    sink->data = realloc(sink->data, sink->len + len);
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+    sink->calls++;
+
+    return true;
+}
+
+TEST(jsean_gen, sink)
+{
+    struct sink sink = {0};
+    jsean_gen *gen;
+    char *expected;
+    size_t len;
+    jsean a, val;
+
+    jsean_set_arr(&a);
+    gen = jsean_gen_new(collect, &sink, "\t", 0);
+    ASSERT(gen != NULL);
+
+    // Enough values to fill the buffer a few times
+    ASSERT(jsean_gen_begin_arr(gen) == JSEAN_SUCCESS);
+    for (int i = 0; i < 50000; i++) {
+        jsean_set_num(&val, i * 0.5);
+        ASSERT(jsean_arr_push(&a, &val) != NULL);
+        ASSERT(jsean_gen_num(gen, i * 0.5) == JSEAN_SUCCESS);
+    }
+    ASSERT(jsean_gen_end(gen) == JSEAN_SUCCESS);
+    ASSERT(jsean_gen_finish(gen, NULL, NULL) == JSEAN_SUCCESS);
+    jsean_gen_free(gen);
+
+    expected = jsean_write(&a, &len, "\t");
+    ASSERT(expected != NULL);
+    ASSERT(sink.calls > 1);
+    ASSERT(sink.len == len);
+    ASSERT(memcmp(sink.data, expected, len) == 0);
+
+    // A failing sink is reported by every call after it
+    free(sink.data);
+    sink = (struct sink){.fail = true};
+    gen = jsean_gen_new(collect, &sink, NULL, 0);
+    ASSERT(gen != NULL);
+    ASSERT(jsean_gen_value(gen, &a) == JSEAN_WRITE_FAILED);
+    ASSERT(jsean_gen_end(gen) == JSEAN_WRITE_FAILED);
+    ASSERT(jsean_gen_finish(gen, NULL, NULL) == JSEAN_WRITE_FAILED);
+    jsean_gen_free(gen);
+
+    free(expected);
+    jsean_free(&a);
+}
@@ -6,6 +6,9 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "jsean.h"
 #include "test.h"
@@ -81,6 +84,33 @@ TEST(jsean_object, add)
     jsean_free(&b);
 }
 
+TEST(jsean_object, add_takes_key)
+{
+    jsean a, b, key;
+
+    jsean_set_obj(&a);
+    jsean_set_null(&b);
+
+    // A short key is copied, and the original freed, so the handle is
+    // cleared, the same as for longer keys
+    ASSERT(jsean_set_str(&key, strdup("k"), 0, free) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_add(&a, &key, &b) != NULL);
+    ASSERT(jsean_get_type(&key) == JSEAN_TYPE_NULL);
+
+    ASSERT(jsean_set_str(&key, strdup("a longer key than fits in a slot"), 0, free) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_set(&a, &key, &b) != NULL);
+    ASSERT(jsean_get_type(&key) == JSEAN_TYPE_NULL);
+
+    // A key in use is left to the caller
+    ASSERT(jsean_set_str(&key, strdup("k"), 0, free) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_add(&a, &key, &b) == NULL);
+    ASSERT(strcmp(jsean_get_str(&key), "k") == 0);
+    jsean_free(&key);
+
+    ASSERT(jsean_obj_len(&a) == 2);
+    jsean_free(&a);
+}
+
 TEST(jsean_object, set)
 {
     jsean a, b, c;
@@ -144,3 +174,200 @@ TEST(jsean_object, clear)
     jsean_free(&a);
     jsean_free(&b);
 }
+
+TEST(jsean_object, key)
+{
+    jsean_key k;
+
+    ASSERT(jsean_key_init(NULL, "a", 1) != JSEAN_SUCCESS);
+    ASSERT(jsean_key_init(&k, NULL, 1) != JSEAN_SUCCESS);
+
+    ASSERT(jsean_key_init(&k, "user_id", 0) == JSEAN_SUCCESS);
+    ASSERT(k.k_len == 7);
+    ASSERT(k.k_hash == JSEAN_K("user_id")->k_hash);
+}
+
+TEST(jsean_object, at_key)
+{
+    jsean a, b;
+
+    ASSERT(jsean_obj_at_key(NULL, JSEAN_K("a")) == NULL);
+
+    jsean_set_obj(&a);
+    ASSERT(jsean_obj_at_key(&a, NULL) == NULL);
+    ASSERT(jsean_obj_at_key(&a, JSEAN_K("a")) == NULL);
+
+    jsean_set_num(&b, 32.0);
+    jsean_obj_add(&a, JSEAN_S("a"), &b);
+    ASSERT(jsean_get_num(jsean_obj_at_key(&a, JSEAN_K("a"))) == 32.0);
+    ASSERT(jsean_obj_at_key(&a, JSEAN_K("b")) == NULL);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_object, set_key)
+{
+    jsean a, b;
+
+    jsean_set_num(&b, 32.0);
+    ASSERT(jsean_obj_set_key(NULL, JSEAN_K("a"), &b) == NULL);
+
+    jsean_set_obj(&a);
+    ASSERT(jsean_obj_set_key(&a, NULL, &b) == NULL);
+    ASSERT(jsean_obj_set_key(&a, JSEAN_K("a"), NULL) == NULL);
+
+    ASSERT(jsean_obj_set_key(&a, JSEAN_K("a"), &b) != NULL);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("a"))) == 32.0);
+
+    jsean_set_num(&b, 64.0);
+    ASSERT(jsean_obj_set_key(&a, JSEAN_K("a"), &b) != NULL);
+    ASSERT(jsean_obj_len(&a) == 1);
+    ASSERT(jsean_get_num(jsean_obj_at_key(&a, JSEAN_K("a"))) == 64.0);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_object, get_many)
+{
+    jsean a, b, keys[3], *out[3];
+
+    jsean_set_str(&keys[0], "a", 1, NULL);
+    jsean_set_str(&keys[1], "missing", 0, NULL);
+    jsean_set_num(&keys[2], 1.0);
+
+    jsean_set_obj(&a);
+    ASSERT(jsean_obj_get_many(&a, keys, 3, out) == 0);
+    ASSERT(out[0] == NULL && out[1] == NULL && out[2] == NULL);
+
+    jsean_set_num(&b, 32.0);
+    jsean_obj_add(&a, JSEAN_S("a"), &b);
+
+    ASSERT(jsean_obj_get_many(NULL, keys, 3, out) == 0);
+    ASSERT(jsean_obj_get_many(&a, keys, 3, out) == 1);
+    ASSERT(jsean_get_num(out[0]) == 32.0);
+    ASSERT(out[1] == NULL && out[2] == NULL);
+
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_get_many(&a, keys, 3, out) == 1);
+    ASSERT(jsean_get_num(out[0]) == 32.0);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_object, get_many_key)
+{
+    char names[40][8];
+    jsean_key keys[40];
+    jsean a, b, key, *out[40];
+
+    jsean_set_obj(&a);
+    for (int i = 0; i < 40; i++) {
+        snprintf(names[i], sizeof(names[i]), "k%d", i);
+        jsean_key_init(&keys[i], names[i], 0);
+
+        // Every other key is missing
+        if (i % 2)
+            continue;
+
+        jsean_set_str(&key, names[i], 0, NULL);
+        jsean_set_num(&b, i);
+        jsean_obj_add(&a, &key, &b);
+    }
+
+    ASSERT(jsean_obj_get_many_key(&a, keys, 40, out) == 20);
+    for (int i = 0; i < 40; i++)
+        ASSERT(i % 2 ? out[i] == NULL : jsean_get_num(out[i]) == i);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_object, entry)
+{
+    jsean a, b, *ptr;
+    bool found;
+
+    jsean_set_obj(&a);
+    ASSERT(jsean_obj_entry(NULL, JSEAN_S("a"), &found) == NULL);
+    ASSERT(jsean_obj_entry(&a, NULL, &found) == NULL);
+
+    jsean_set_str(&b, "a", 1, NULL);
+    ptr = jsean_obj_entry(&a, &b, &found);
+    ASSERT(ptr != NULL);
+    ASSERT(found == false);
+    ASSERT(jsean_get_type(ptr) == JSEAN_TYPE_NULL);
+    ASSERT(jsean_get_type(&b) == JSEAN_TYPE_NULL);
+    jsean_set_num(ptr, 32.0);
+
+    jsean_set_str(&b, "a", 1, NULL);
+    ptr = jsean_obj_entry(&a, &b, &found);
+    ASSERT(ptr != NULL);
+    ASSERT(found == true);
+    ASSERT(jsean_get_num(ptr) == 32.0);
+    ASSERT(jsean_obj_len(&a) == 1);
+
+    // Dead slots are reused
+    jsean_obj_del(&a, JSEAN_S("a"));
+    ASSERT(jsean_obj_entry(&a, JSEAN_S("a"), NULL) != NULL);
+    ASSERT(jsean_obj_len(&a) == 1);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_object, reserve)
+{
+    char names[100][8];
+    jsean a, b, key;
+
+    jsean_set_null(&b);
+    ASSERT(jsean_obj_reserve(&b, 10) != JSEAN_SUCCESS);
+
+    jsean_set_obj(&a);
+    ASSERT(jsean_obj_reserve(&a, 100) == JSEAN_SUCCESS);
+
+    for (int i = 0; i < 100; i++) {
+        snprintf(names[i], sizeof(names[i]), "k%d", i);
+        jsean_set_str(&key, names[i], 0, NULL);
+        jsean_set_num(&b, i);
+        ASSERT(jsean_obj_add(&a, &key, &b) != NULL);
+    }
+
+    ASSERT(jsean_obj_len(&a) == 100);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("k99"))) == 99);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_object, compact)
+{
+    char names[100][8];
+    jsean a, b, key;
+
+    jsean_set_obj(&a);
+    ASSERT(jsean_obj_compact(&a) == JSEAN_SUCCESS);
+
+    for (int i = 0; i < 100; i++) {
+        snprintf(names[i], sizeof(names[i]), "k%d", i);
+        jsean_set_str(&key, names[i], 0, NULL);
+        jsean_set_num(&b, i);
+        jsean_obj_add(&a, &key, &b);
+    }
+
+    for (int i = 0; i < 90; i++) {
+        jsean_set_str(&key, names[i], 0, NULL);
+        jsean_obj_del(&a, &key);
+    }
+
+    ASSERT(jsean_obj_compact(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_len(&a) == 10);
+    ASSERT(jsean_obj_at(&a, JSEAN_S("k0")) == NULL);
+    for (int i = 90; i < 100; i++) {
+        jsean_set_str(&key, names[i], 0, NULL);
+        ASSERT(jsean_get_num(jsean_obj_at(&a, &key)) == i);
+    }
+
+    ASSERT(jsean_freeze(&a) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_compact(&a) == JSEAN_FROZEN);
+    ASSERT(jsean_obj_reserve(&a, 10) == JSEAN_FROZEN);
+
+    jsean_free(&a);
+}
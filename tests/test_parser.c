@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "jsean.h"
+#include "test.h"
+
+TEST(jsean_parser, read)
+{
+    jsean_parser *parser;
+    jsean a;
+
+    parser = jsean_parser_new(0, NULL);
+    ASSERT(parser != NULL);
+
+    ASSERT(jsean_parser_read(NULL, &a, JSEAN_S("[]")) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_parser_read(parser, NULL, JSEAN_S("[]")) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_parser_read(parser, &a, NULL) == JSEAN_INVALID_ARGUMENTS);
+
+    // The parser can be used again, even after an error
+    for (int i = 0; i < 10; i++) {
+        ASSERT(jsean_parser_read(parser, &a, JSEAN_S("{\"key\": \"a string longer than the scratch buffer starts out as, to make it grow\"}")) == JSEAN_SUCCESS);
+        ASSERT(jsean_str_len(jsean_obj_at(&a, JSEAN_S("key"))) == 70);
+        jsean_free(&a);
+
+        ASSERT(jsean_parser_read(parser, &a, JSEAN_S("[\"unterminated")) != JSEAN_SUCCESS);
+
+        ASSERT(jsean_parser_read(parser, &a, JSEAN_S("[1, \"two\"]")) == JSEAN_SUCCESS);
+        ASSERT(jsean_arr_len(&a) == 2);
+        ASSERT(memcmp(jsean_get_str(jsean_arr_at(&a, 1)), "two", 3) == 0);
+        jsean_free(&a);
+    }
+
+    jsean_parser_free(parser);
+    jsean_parser_free(NULL);
+}
+
+TEST(jsean_parser, reset)
+{
+    jsean_parser *parser;
+    jsean a;
+
+    parser = jsean_parser_new(0, NULL);
+    ASSERT(parser != NULL);
+
+    ASSERT(jsean_parser_read(parser, &a, JSEAN_S("{\"a\": 1, \"a\": 2}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_len(&a) == 1);
+    jsean_free(&a);
+
+    jsean_parser_reset(parser, JSEAN_READ_UNIQUE_KEYS, NULL);
+    ASSERT(jsean_parser_read(parser, &a, JSEAN_S("{\"a\": 1, \"b\": 2}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_len(&a) == 2);
+    jsean_free(&a);
+
+    jsean_parser_reset(NULL, 0, NULL);
+    jsean_parser_free(parser);
+}
+
+TEST(jsean_parser, read_stream)
+{
+    jsean_parser *parser;
+    FILE *fp;
+    jsean a;
+
+    parser = jsean_parser_new(0, NULL);
+    ASSERT(parser != NULL);
+
+    for (int i = 0; i < 2; i++) {
+        fp = fopen(SAMPLES_DIR "/64KB.json", "r");
+        ASSERT(fp != NULL);
+
+        ASSERT(jsean_parser_read_stream(parser, &a, fp) == JSEAN_SUCCESS);
+        ASSERT(jsean_get_type(&a) == JSEAN_TYPE_ARRAY);
+        ASSERT(jsean_arr_len(&a) > 0);
+
+        fclose(fp);
+        jsean_free(&a);
+    }
+
+    jsean_parser_free(parser);
+}
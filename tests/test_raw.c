@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsean.h"
+#include "test.h"
+
+TEST(jsean_raw, set)
+{
+    jsean a;
+
+    ASSERT(jsean_set_raw(NULL, "1", 0, NULL) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_set_raw(&a, NULL, 0, NULL) == JSEAN_INVALID_ARGUMENTS);
+
+    ASSERT(jsean_set_raw(&a, "{\"a\": [1, 2]}", 0, NULL) == JSEAN_SUCCESS);
+    ASSERT(jsean_get_type(&a) == JSEAN_TYPE_RAW);
+    ASSERT(jsean_raw_len(&a) == 13);
+    ASSERT(strcmp(jsean_get_raw(&a), "{\"a\": [1, 2]}") == 0);
+
+    // Raw text is not a string
+    ASSERT(jsean_get_str(&a) == NULL);
+    ASSERT(jsean_str_len(&a) == 0);
+
+    jsean_set_null(&a);
+    ASSERT(jsean_get_raw(&a) == NULL);
+    ASSERT(jsean_raw_len(&a) == 0);
+}
+
+TEST(jsean_raw, checked)
+{
+    jsean a;
+
+    ASSERT(jsean_set_raw_checked(&a, "[1, {\"b\": null}]", 0, NULL) == JSEAN_SUCCESS);
+    ASSERT(jsean_get_type(&a) == JSEAN_TYPE_RAW);
+
+    jsean_set_null(&a);
+    ASSERT(jsean_set_raw_checked(&a, "[1, ", 0, NULL) != JSEAN_SUCCESS);
+    ASSERT(jsean_set_raw_checked(&a, "{\"a\": 1} x", 0, NULL) != JSEAN_SUCCESS);
+    ASSERT(jsean_get_type(&a) == JSEAN_TYPE_NULL);
+
+    // The same errors as from reading the text
+    ASSERT(jsean_set_raw_checked(NULL, "1", 0, NULL) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_set_raw_checked(&a, "{\"a\": 1} x", 0, NULL) == JSEAN_EXPECTED_WHITESPACE);
+    ASSERT(jsean_set_raw_checked(&a, "[1 2]", 0, NULL) == JSEAN_EXPECTED_COMMA);
+    ASSERT(jsean_set_raw_checked(&a, "{\"a\" 1}", 0, NULL) != JSEAN_SUCCESS);
+    ASSERT(jsean_set_raw_checked(&a, "[01]", 0, NULL) == JSEAN_EXPECTED_COMMA);
+    ASSERT(jsean_set_raw_checked(&a, "-", 0, NULL) == JSEAN_EXPECTED_NONZERO_DIGIT);
+    ASSERT(jsean_set_raw_checked(&a, "1.", 0, NULL) == JSEAN_EXPECTED_DIGIT);
+    ASSERT(jsean_set_raw_checked(&a, "\"a\\x\"", 0, NULL) == JSEAN_INVALID_ESCAPE_SEQUENCE);
+    ASSERT(jsean_set_raw_checked(&a, "\"\\ud800\"", 0, NULL) == JSEAN_INVALID_UNICODE_ESCAPE_SEQUENCE);
+    ASSERT(jsean_set_raw_checked(&a, "\"\xc0\x80\"", 0, NULL) == JSEAN_INVALID_UTF8_SEQUENCE);
+    ASSERT(jsean_set_raw_checked(&a, "\"abc", 0, NULL) == JSEAN_EXPECTED_QUOTATION_MARK);
+    ASSERT(jsean_set_raw_checked(&a, "nul", 0, NULL) == JSEAN_EXPECTED_NULL);
+    ASSERT(jsean_set_raw_checked(&a, "", 0, NULL) == JSEAN_EXPECTED_VALUE);
+    ASSERT(jsean_get_type(&a) == JSEAN_TYPE_NULL);
+
+    // Long strings, numbers and nesting are checked without keeping them
+    ASSERT(jsean_set_raw_checked(&a, "{\"a long key, longer than a small string\": [[-1.5e3, \"\\u00e9\xc3\xa9\"], {}]}", 0, NULL) == JSEAN_SUCCESS);
+    ASSERT(jsean_get_type(&a) == JSEAN_TYPE_RAW);
+}
+
+TEST(jsean_raw, write)
+{
+    jsean a, val;
+    size_t len;
+    char *buf, *str;
+
+    // The text is written as it is, whitespace and all
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\": [\"x\"]}")) == JSEAN_SUCCESS);
+
+    str = malloc(16);
+    ASSERT(str != NULL);
+    strcpy(str, "{ \"cached\":1 }");
+    ASSERT(jsean_set_raw(&val, str, 0, free) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_push(jsean_obj_at(&a, JSEAN_S("a")), &val) != NULL);
+
+    buf = jsean_write(&a, &len, NULL);
+    ASSERT(buf != NULL);
+    ASSERT(strcmp(buf, "{\"a\":[\"x\",{ \"cached\":1 }]}") == 0);
+    ASSERT(jsean_write_size(&a, NULL) == len);
+    free(buf);
+
+    buf = jsean_write(&a, &len, "  ");
+    ASSERT(buf != NULL);
+    ASSERT(strcmp(buf, "{\n  \"a\": [\n  \"x\",\n  { \"cached\":1 }\n]\n}") == 0);
+    ASSERT(jsean_write_size(&a, "  ") == len);
+    free(buf);
+
+    jsean_free(&a);
+}
@@ -55,3 +55,43 @@ TEST(jsean_read_array, expected_value)
 
     ASSERT(jsean_read(&a, JSEAN_S("[true, ]")) == JSEAN_EXPECTED_VALUE);
 }
+
+// Reading never packs arrays, so reading values doesn't change them
+TEST(jsean_read_array, numbers_not_packed)
+{
+    const jsean *nums;
+    jsean a;
+
+    ASSERT(jsean_read(&a, JSEAN_S("[1, 2, 3, [4, 5], [6, \"7\"]]")) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_num_data(&a, NULL) == NULL);
+
+    nums = jsean_arr_at(&a, 3);
+    ASSERT(jsean_arr_num_data((jsean *)nums, NULL) == NULL);
+    ASSERT(jsean_arr_num(nums, 1) == 5.0);
+    ASSERT(jsean_arr_at(&a, 3) == nums);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_read_array, numbers_packed)
+{
+    const jsean *nums;
+    size_t len;
+    jsean a;
+
+    ASSERT(jsean_read_ex(&a, JSEAN_S("[[1, 2.5, -3], [], [4, \"5\"]]"), JSEAN_READ_PACK_NUMBERS) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_num_data(&a, NULL) == NULL);
+
+    nums = jsean_arr_at(&a, 0);
+    ASSERT(jsean_arr_num_data((jsean *)nums, &len) != NULL);
+    ASSERT(len == 3);
+    ASSERT(jsean_arr_num(nums, 1) == 2.5);
+    ASSERT(jsean_arr_at(nums, 1) == NULL);
+
+    // Empty arrays, and arrays with anything but numbers, aren't packed
+    ASSERT(jsean_arr_num_data(jsean_arr_at(&a, 1), NULL) == NULL);
+    ASSERT(jsean_arr_num_data(jsean_arr_at(&a, 2), NULL) == NULL);
+    ASSERT(jsean_arr_num(jsean_arr_at(&a, 2), 0) == 4.0);
+
+    jsean_free(&a);
+}
@@ -4,6 +4,9 @@
 // Licensed under the BSD 2-Clause License. See LICENSE.txt
 //
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "jsean.h"
 #include "test.h"
 
@@ -61,3 +64,55 @@ TEST(jsean_read_object, expected_quotation_mark)
 
     ASSERT(jsean_read(&a, JSEAN_S("{\"a\":1,}")) == JSEAN_EXPECTED_QUOTATION_MARK);
 }
+
+TEST(jsean_read_object, duplicate_keys)
+{
+    jsean a;
+
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\": 1, \"b\": 2, \"a\": 3}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_len(&a) == 2);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("a"))) == 3);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_read_object, unique_keys)
+{
+    jsean a;
+
+    ASSERT(jsean_read_ex(&a, JSEAN_S("{\"a\": 1, \"b\": {\"c\": 2}}"), JSEAN_READ_UNIQUE_KEYS) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_len(&a) == 2);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("a"))) == 1);
+    ASSERT(jsean_get_num(jsean_obj_at(jsean_obj_at(&a, JSEAN_S("b")), JSEAN_S("c"))) == 2);
+
+    jsean_free(&a);
+}
+
+TEST(jsean_read_object, key_lengths)
+{
+    jsean a, b;
+    char *buf;
+
+    // Keys of up to 8 bytes are stored in the table itself
+    ASSERT(jsean_read(&a, JSEAN_S("{\"\":1,\"abcdefgh\":2,\"abcdefghi\":3,\"abcdefghijklm\":4}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_obj_len(&a) == 4);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S(""))) == 1.0);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("abcdefgh"))) == 2.0);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("abcdefghi"))) == 3.0);
+    ASSERT(jsean_get_num(jsean_obj_at(&a, JSEAN_S("abcdefghijklm"))) == 4.0);
+
+    jsean_obj_del(&a, JSEAN_S(""));
+    ASSERT(jsean_obj_at(&a, JSEAN_S("")) == NULL);
+    ASSERT(jsean_obj_len(&a) == 3);
+
+    jsean_set_num(&b, 5.0);
+    ASSERT(jsean_obj_add(&a, JSEAN_S(""), &b) != NULL);
+
+    buf = jsean_write(&a, NULL, NULL);
+    ASSERT(buf != NULL);
+    ASSERT(strstr(buf, "\"abcdefghijklm\":4") != NULL);
+    ASSERT(strstr(buf, "\"\":5") != NULL);
+
+    free(buf);
+    jsean_free(&a);
+}
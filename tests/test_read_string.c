@@ -27,6 +27,9 @@
     }
 
 TEST_STRING(hello, "\"hello, world\"", "hello, world");
+TEST_STRING(empty, "\"\"", "");
+TEST_STRING(short, "\"abcdefghijk\"", "abcdefghijk");
+TEST_STRING(short_null, "\"a\\u0000b\"", "a\0b");
 
 TEST_STRING(quotation_mark, "\"\\\"\"", "\"");
 TEST_STRING(reverse_solidus, "\"\\\\\"", "\\");
@@ -51,3 +54,37 @@ TEST_ERROR(invalid_unicode3, "\"\\u00\"", JSEAN_INVALID_UNICODE_ESCAPE_SEQUENCE)
 TEST_ERROR(invalid_unicode4, "\"\\u000\"", JSEAN_INVALID_UNICODE_ESCAPE_SEQUENCE);
 TEST_ERROR(invalid_surrogate, "\"\\ud852\"", JSEAN_INVALID_UNICODE_ESCAPE_SEQUENCE);
 TEST_ERROR(invalid_surrogate2, "\"\\ud852\\u0061\"", JSEAN_INVALID_UNICODE_ESCAPE_SEQUENCE);
+
+TEST(jsean_read_string, short_terminated)
+{
+    jsean a;
+
+    ASSERT(jsean_read(&a, JSEAN_S("\"abcdefghijk\"")) == JSEAN_SUCCESS);
+    ASSERT(jsean_str_len(&a) == 11);
+    ASSERT(strcmp(jsean_get_str(&a), "abcdefghijk") == 0);
+    jsean_free(&a);
+
+    ASSERT(jsean_read(&a, JSEAN_S("\"abcdefghijkl\"")) == JSEAN_SUCCESS);
+    ASSERT(jsean_str_len(&a) == 12);
+    ASSERT(memcmp(jsean_get_str(&a), "abcdefghijkl", 12) == 0);
+    jsean_free(&a);
+}
+
+#define TEST_FLAGS(name, input, flags)                           \
+    TEST(jsean_read_string, flags_##name)                        \
+    {                                                            \
+        jsean a;                                                 \
+        ASSERT(jsean_read(&a, JSEAN_S(input)) == JSEAN_SUCCESS); \
+        ASSERT(a.s_known);                                       \
+        ASSERT(jsean_str_flags(&a) == (flags));                  \
+        jsean_free(&a);                                          \
+    }
+
+TEST_FLAGS(plain, "\"a string longer than a small one\"", JSEAN_STR_ASCII);
+TEST_FLAGS(small, "\"abc\"", JSEAN_STR_ASCII);
+TEST_FLAGS(solidus, "\"\\/\"", JSEAN_STR_ASCII);
+TEST_FLAGS(line_feed, "\"a string with a \\n in it\"", JSEAN_STR_ESCAPE | JSEAN_STR_ASCII);
+TEST_FLAGS(control, "\"\\u0001\"", JSEAN_STR_ESCAPE | JSEAN_STR_ASCII);
+TEST_FLAGS(non_ascii, "\"a string with \xc3\xa4 in it\"", 0);
+TEST_FLAGS(non_ascii_escape, "\"\\u00e4\"", 0);
+TEST_FLAGS(both, "\"\xc3\xa4\\\"\"", JSEAN_STR_ESCAPE);
@@ -123,6 +123,90 @@ TEST(jsean_string, set_str)
     jsean_free(&a);
 }
 
+static int free_count;
+
+static void counting_free(void *ptr)
+{
+    free_count++;
+    free(ptr);
+}
+
+TEST(jsean_string, free_fn)
+{
+    jsean a, b;
+
+    free_count = 0;
+
+    ASSERT(jsean_set_str(&a, strdup("abc"), 3, counting_free) == JSEAN_SUCCESS);
+    ASSERT(jsean_set_str(&b, strdup("def"), 3, counting_free) == JSEAN_SUCCESS);
+    jsean_free(&a);
+    ASSERT(free_count == 1);
+    jsean_free(&b);
+    ASSERT(free_count == 2);
+
+    // Keys with a custom free function are copied, and freed right away
+    jsean_set_obj(&a);
+    jsean_set_str(&b, strdup("key"), 3, counting_free);
+    ASSERT(jsean_obj_add(&a, &b, JSEAN_S("value")) != NULL);
+    ASSERT(free_count == 3);
+    ASSERT(jsean_obj_at(&a, JSEAN_S("key")) != NULL);
+    jsean_free(&a);
+}
+
+// Distinct functions, 128 of them, to fill the table of free functions
+#define FREE_FN(i_) static void free_##i_(void *ptr) { free_count = i_; free(ptr); }
+#define FREE_FN_PTR(i_) free_##i_,
+#define REPEAT_8(m_, i_) m_(i_##0) m_(i_##1) m_(i_##2) m_(i_##3) m_(i_##4) m_(i_##5) m_(i_##6) m_(i_##7)
+#define REPEAT_64(m_, i_) REPEAT_8(m_, i_##0) REPEAT_8(m_, i_##1) REPEAT_8(m_, i_##2) REPEAT_8(m_, i_##3) \
+    REPEAT_8(m_, i_##4) REPEAT_8(m_, i_##5) REPEAT_8(m_, i_##6) REPEAT_8(m_, i_##7)
+
+REPEAT_64(FREE_FN, 0)
+REPEAT_64(FREE_FN, 1)
+
+static void (*const free_fns[])(void *) = {
+    REPEAT_64(FREE_FN_PTR, 0)
+    REPEAT_64(FREE_FN_PTR, 1)
+};
+
+// The table is never emptied, so this runs after the other tests that add
+// functions to it, and counting_free() is added first in any case
+TEST(jsean_string, free_fn_limit)
+{
+    size_t i, n = sizeof(free_fns) / sizeof(*free_fns);
+    int status = JSEAN_SUCCESS;
+    char *str;
+    jsean a;
+
+    ASSERT(jsean_set_str(&a, strdup("abc"), 3, counting_free) == JSEAN_SUCCESS);
+    jsean_free(&a);
+
+    for (i = 0; i < n; i++) {
+        str = strdup("abc");
+        status = jsean_set_str(&a, str, 3, free_fns[i]);
+        if (status != JSEAN_SUCCESS) {
+            free(str);
+            break;
+        }
+        jsean_free(&a);
+    }
+
+    // Room for 126 functions besides free(), one of them counting_free()
+    ASSERT(status == JSEAN_TOO_MANY_FREE_FUNCTIONS);
+    ASSERT(i <= 125);
+
+    // Functions already in the table still work, as do free() and NULL
+    ASSERT(jsean_set_str(&a, strdup("abc"), 3, free_fns[0]) == JSEAN_SUCCESS);
+    jsean_free(&a);
+    ASSERT(jsean_set_str(&a, strdup("abc"), 3, counting_free) == JSEAN_SUCCESS);
+    jsean_free(&a);
+    ASSERT(jsean_set_str(&a, strdup("abc"), 3, free) == JSEAN_SUCCESS);
+    jsean_free(&a);
+    ASSERT(jsean_set_str(&a, "abc", 3, NULL) == JSEAN_SUCCESS);
+    jsean_free(&a);
+
+    ASSERT(jsean_set_raw(&a, "[]", 2, free_fns[n - 1]) == JSEAN_TOO_MANY_FREE_FUNCTIONS);
+}
+
 TEST(jsean_string, get_str)
 {
     jsean a;
@@ -99,3 +99,20 @@ TEST(jsean_write_array, strings_space)
     jsean_free(&a);
     free(buf);
 }
+
+TEST(jsean_write_array, numbers)
+{
+    jsean a;
+    char *buf;
+
+    ASSERT(jsean_read(&a, JSEAN_S("[1,2.5,300]")) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_pack(&a) == JSEAN_SUCCESS);
+
+    buf = jsean_write(&a, NULL, NULL);
+    ASSERT(buf != NULL);
+    ASSERT(strcmp(buf, "[1,2.5,300]") == 0);
+    ASSERT(jsean_arr_num_data(&a, NULL) != NULL);
+
+    jsean_free(&a);
+    free(buf);
+}
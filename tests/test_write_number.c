@@ -4,6 +4,8 @@
 // Licensed under the BSD 2-Clause License. See LICENSE.txt
 //
 
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -32,7 +34,7 @@ TEST_NUMBER(zero, 0.0, "0");
 TEST_NUMBER(non_zero, 1.0, "1");
 TEST_NUMBER(non_zero2, 1.1, "1.1");
 TEST_NUMBER(non_zero3, 1.000001, "1.000001");
-TEST_NUMBER(non_zero4, 1.0000001, "1");
+TEST_NUMBER(non_zero4, 1.0000001, "1.0000001");
 
 TEST_NUMBER(exp, 1e20, "100000000000000000000");
 TEST_NUMBER(exp2, 1e100, "1e+100");
@@ -42,3 +44,93 @@ TEST_NUMBER(exp5, 1.1e20, "110000000000000000000");
 TEST_NUMBER(exp6, 1.1e100, "1.1e+100");
 TEST_NUMBER(exp7, 1.1e-5, "0.000011");
 TEST_NUMBER(exp8, 1.1e-10, "1.1e-10");
+
+TEST_NUMBER(negative, -3.0, "-3");
+TEST_NUMBER(negative2, -0.5, "-0.5");
+TEST_NUMBER(negative3, -1.5e-10, "-1.5e-10");
+TEST_NUMBER(negative_zero, -0.0, "0");
+
+TEST_NUMBER(shortest, 0.1, "0.1");
+TEST_NUMBER(shortest2, 0.1 + 0.2, "0.30000000000000004");
+TEST_NUMBER(shortest3, 1.0 / 3.0, "0.3333333333333333");
+TEST_NUMBER(shortest4, 123456.789, "123456.789");
+TEST_NUMBER(shortest5, 9007199254740993.0, "9007199254740992");
+
+// Same thresholds as JavaScript
+TEST_NUMBER(threshold, 1e21, "1e+21");
+TEST_NUMBER(threshold2, 123456789012345680000.0, "123456789012345680000");
+TEST_NUMBER(threshold3, 1e-6, "0.000001");
+TEST_NUMBER(threshold4, 1e-7, "1e-7");
+TEST_NUMBER(threshold5, 1.5e-7, "1.5e-7");
+
+TEST_NUMBER(limits, 5e-324, "5e-324");
+TEST_NUMBER(limits2, 2.2250738585072014e-308, "2.2250738585072014e-308");
+TEST_NUMBER(limits3, 1.7976931348623157e308, "1.7976931348623157e+308");
+
+// xorshift64*, so that failures can be reproduced
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+
+    return *state * 0x2545f4914f6cdd1d;
+}
+
+// Counts the digits from the first non-zero one to the last one before the
+// exponent, ignoring the decimal point
+static int significant_digits(const char *str)
+{
+    const char *first, *last;
+    int len = 0;
+
+    first = str + strcspn(str, "123456789");
+    last = str + strcspn(str, "e");
+
+    for (const char *p = first; p < last; p++)
+        len += *p != '.';
+
+    // Trailing zeros of integers are not significant
+    while (last > first && (last[-1] == '0' || last[-1] == '.')) {
+        len -= last[-1] == '0';
+        last--;
+    }
+
+    return len;
+}
+
+TEST(jsean_write_number, round_trip)
+{
+    uint64_t state = 0x9e3779b97f4a7c15, bits;
+    char *buf, tmp[32];
+    double num;
+    jsean a;
+    int len;
+
+    for (int i = 0; i < 100000; i++) {
+        bits = next_random(&state);
+
+        // Every other number is a short decimal, which random bits rarely are
+        if (i % 2)
+            memcpy(&num, &bits, sizeof(num));
+        else
+            for (num = bits >> 40, len = bits % 10; len > 0; len--)
+                num /= 10;
+
+        if (jsean_set_num(&a, num) != JSEAN_SUCCESS)
+            continue;
+
+        buf = jsean_write(&a, NULL, NULL);
+        ASSERT(buf != NULL);
+        ASSERT(strtod(buf, NULL) == num);
+
+        // Rounded to one digit less, the number no longer reads back
+        len = significant_digits(buf);
+        if (len > 1) {
+            snprintf(tmp, sizeof(tmp), "%.*e", len - 2, num);
+            ASSERT(strtod(tmp, NULL) != num);
+        }
+
+        free(buf);
+    }
+}
@@ -0,0 +1,189 @@
+//
+// Copyright (c) 2025, sonkajarvi
+//
+// Licensed under the BSD 2-Clause License. See LICENSE.txt
+//
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "jsean.h"
+#include "test.h"
+
+struct sink {
+    char *data;
+    size_t len;
+    size_t calls;
+    size_t fail_after;
+};
+
+static bool collect(void *ctx, const char *data, size_t len)
+{
+    struct sink *sink = ctx;
+
+    if (sink->fail_after && sink->calls == sink->fail_after)
+        return false;
+
+    sink->data = realloc(sink->data, sink->len + len);
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+    sink->calls++;
+
+    return true;
+}
+
+TEST(jsean_write_stream, callback)
+{
+    struct sink sink = {0};
+    size_t len;
+    char *str;
+    FILE *fp;
+    jsean a;
+
+    fp = fopen(SAMPLES_DIR "/1MB.json", "r");
+    ASSERT(fp != NULL);
+    ASSERT(jsean_read_stream(&a, fp) == JSEAN_SUCCESS);
+    fclose(fp);
+
+    ASSERT(jsean_write_cb(NULL, collect, &sink, NULL) == JSEAN_INVALID_ARGUMENTS);
+    ASSERT(jsean_write_cb(&a, NULL, &sink, NULL) == JSEAN_INVALID_ARGUMENTS);
+
+    // The output comes in many pieces, which add up to the same text
+    str = jsean_write(&a, &len, "  ");
+    ASSERT(str != NULL);
+    ASSERT(jsean_write_cb(&a, collect, &sink, "  ") == JSEAN_SUCCESS);
+    ASSERT(sink.calls > 1);
+    ASSERT(sink.len == len);
+    ASSERT(memcmp(sink.data, str, len) == 0);
+
+    // Flags are the same as for jsean_write_ex()
+    free(sink.data);
+    free(str);
+    sink = (struct sink){0};
+    str = jsean_write_ex(&a, &len, NULL, JSEAN_WRITE_ASCII);
+    ASSERT(str != NULL);
+    ASSERT(jsean_write_cb_ex(&a, collect, &sink, NULL, JSEAN_WRITE_ASCII) == JSEAN_SUCCESS);
+    ASSERT(sink.len == len);
+    ASSERT(memcmp(sink.data, str, len) == 0);
+
+    // A failing sink stops writing
+    free(sink.data);
+    sink = (struct sink){.fail_after = 2};
+    ASSERT(jsean_write_cb(&a, collect, &sink, "  ") == JSEAN_WRITE_FAILED);
+    ASSERT(sink.calls == 2);
+
+    free(sink.data);
+    free(str);
+    jsean_free(&a);
+}
+
+TEST(jsean_write_stream, file)
+{
+    char buf[64];
+    FILE *fp;
+    jsean a;
+
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\": [1, 2.5, \"x\\n\"], \"b\": null}")) == JSEAN_SUCCESS);
+
+    ASSERT(jsean_write_stream(&a, NULL, NULL) == JSEAN_INVALID_ARGUMENTS);
+
+    fp = tmpfile();
+    ASSERT(fp != NULL);
+    ASSERT(jsean_write_stream(&a, fp, NULL) == JSEAN_SUCCESS);
+
+    rewind(fp);
+    memset(buf, 0, sizeof(buf));
+    ASSERT(fread(buf, 1, sizeof(buf) - 1, fp) == 28);
+    ASSERT(strcmp(buf, "{\"a\":[1,2.5,\"x\\n\"],\"b\":null}") == 0);
+
+    fclose(fp);
+    jsean_free(&a);
+}
+
+// Joins the pieces, and checks that the long string is pointed to
+static char *join_iov(const jsean_iov *iov, const char *str, bool *referenced)
+{
+    const struct iovec *vec;
+    size_t count, len = 0;
+    char *buf;
+
+    vec = jsean_iov_vec(iov, &count);
+    buf = malloc(jsean_iov_len(iov) + 1);
+
+    *referenced = false;
+    for (size_t i = 0; i < count; i++) {
+        if (vec[i].iov_base == str)
+            *referenced = true;
+
+        memcpy(buf + len, vec[i].iov_base, vec[i].iov_len);
+        len += vec[i].iov_len;
+    }
+    buf[len] = '\0';
+
+    return buf;
+}
+
+TEST(jsean_write_stream, iov)
+{
+    const char *indents[] = {NULL, "\t"};
+    char *str, *raw, *expected, *buf;
+    bool referenced;
+    jsean_iov *iov;
+    jsean a, val;
+    size_t count;
+
+    ASSERT(jsean_write_iov(NULL, NULL, 0) == NULL);
+    ASSERT(jsean_iov_vec(NULL, &count) == NULL);
+    ASSERT(count == 0);
+    ASSERT(jsean_iov_len(NULL) == 0);
+    jsean_iov_free(NULL);
+
+    // A long string, a long raw value, and enough else to fill a few chunks
+    str = malloc(5000);
+    ASSERT(str != NULL);
+    memset(str, 'x', 4999);
+    str[4999] = '\0';
+
+    raw = malloc(1000);
+    ASSERT(raw != NULL);
+    memset(raw, ' ', 999);
+    raw[0] = '[';
+    raw[997] = ']';
+    raw[999] = '\0';
+
+    ASSERT(jsean_read(&a, JSEAN_S("[\"short\", {\"a\": \"b\\n\"}]")) == JSEAN_SUCCESS);
+    ASSERT(jsean_set_str(&val, str, 0, free) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_push(&a, &val) != NULL);
+    ASSERT(jsean_set_raw(&val, raw, 0, free) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_push(&a, &val) != NULL);
+    for (int i = 0; i < 2000; i++) {
+        jsean_set_num(&val, i + 0.5);
+        ASSERT(jsean_arr_push(&a, &val) != NULL);
+    }
+
+    for (size_t i = 0; i < sizeof(indents) / sizeof(*indents); i++) {
+        iov = jsean_write_iov(&a, indents[i], 0);
+        ASSERT(iov != NULL);
+
+        expected = jsean_write(&a, NULL, indents[i]);
+        ASSERT(expected != NULL);
+        ASSERT(jsean_iov_len(iov) == strlen(expected));
+
+        buf = join_iov(iov, str, &referenced);
+        ASSERT(referenced);
+        ASSERT(strcmp(buf, expected) == 0);
+
+        free(buf);
+        buf = join_iov(iov, raw, &referenced);
+        ASSERT(referenced);
+
+        free(buf);
+        free(expected);
+        jsean_iov_free(iov);
+    }
+
+    jsean_free(&a);
+}
@@ -4,6 +4,7 @@
 // Licensed under the BSD 2-Clause License. See LICENSE.txt
 //
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -37,3 +38,125 @@ TEST_STRING(form_feed, "\x0c", 1, "\"\\f\"");
 TEST_STRING(carriage_return, "\x0d", 1, "\"\\r\"");
 TEST_STRING(quotation_mark, "\x22", 1, "\"\\\"\"");
 TEST_STRING(reverse_solidus, "\x5c", 1, "\"\\\\\"");
+TEST_STRING(delete, "\x7f", 1, "\"\x7f\"");
+TEST_STRING(non_ascii, "h\xc3\xa4", 0, "\"h\xc3\xa4\"");
+
+// Strings are scanned a block at a time, so try every position in a few blocks
+TEST(jsean_write_string, positions)
+{
+    const char specials[] = {'\x01', '\x1f', '"', '\\', ' ', '\x7f', '\x80'};
+    char str[48], expected[64];
+    size_t len;
+    jsean a;
+    char *buf;
+
+    for (size_t s = 0; s < sizeof(specials); s++) {
+        for (size_t i = 0; i < sizeof(str); i++) {
+            memset(str, 'a', sizeof(str));
+            str[i] = specials[s];
+            jsean_set_str(&a, str, sizeof(str), NULL);
+
+            len = 0;
+            expected[len++] = '"';
+            memset(&expected[len], 'a', i);
+            len += i;
+
+            if (specials[s] == '\x01' || specials[s] == '\x1f')
+                len += sprintf(&expected[len], "\\u%04x", specials[s]);
+            else if (specials[s] == '"' || specials[s] == '\\')
+                len += sprintf(&expected[len], "\\%c", specials[s]);
+            else
+                expected[len++] = specials[s];
+
+            memset(&expected[len], 'a', sizeof(str) - i - 1);
+            len += sizeof(str) - i - 1;
+            expected[len++] = '"';
+            expected[len] = '\0';
+
+            buf = jsean_write(&a, NULL, NULL);
+            ASSERT(buf != NULL);
+            ASSERT(strcmp(buf, expected) == 0);
+            ASSERT(jsean_write_size(&a, NULL) == len);
+
+            free(buf);
+            jsean_free(&a);
+        }
+    }
+}
+
+// Also written into a buffer of exactly the right size
+#define TEST_STRING_ASCII(name, input, len, output)                                  \
+    TEST(jsean_write_string, ascii_##name)                                           \
+    {                                                                                \
+        char exact[sizeof(output) - 1];                                              \
+        jsean a;                                                                     \
+        char *buf;                                                                   \
+                                                                                     \
+        jsean_set_str(&a, input, len, NULL);                                         \
+        ASSERT(jsean_get_type(&a) == JSEAN_TYPE_STRING);                             \
+                                                                                     \
+        buf = jsean_write_ex(&a, NULL, NULL, JSEAN_WRITE_ASCII);                     \
+        ASSERT(buf != NULL);                                                         \
+        ASSERT(strcmp(buf, output) == 0);                                            \
+                                                                                     \
+        ASSERT(jsean_write_to_ex(&a, exact, sizeof(exact), NULL, JSEAN_WRITE_ASCII)  \
+            == sizeof(exact));                                                       \
+        ASSERT(memcmp(exact, output, sizeof(exact)) == 0);                           \
+                                                                                     \
+        jsean_free(&a);                                                              \
+        free(buf);                                                                   \
+    }
+
+TEST_STRING_ASCII(hello, "hello, world\n", 0, "\"hello, world\\n\"");
+TEST_STRING_ASCII(two_bytes, "h\xc3\xa4", 0, "\"h\\u00e4\"");
+TEST_STRING_ASCII(three_bytes, "\xe2\x82\xac", 0, "\"\\u20ac\"");
+TEST_STRING_ASCII(four_bytes, "\xf0\x9f\x98\x80", 0, "\"\\ud83d\\ude00\"");
+TEST_STRING_ASCII(long, "a long string with \xc3\xa4 in it", 0, "\"a long string with \\u00e4 in it\"");
+TEST_STRING_ASCII(invalid, "\xff", 0, "\"\\ufffd\"");
+TEST_STRING_ASCII(overlong, "\xc0\xaf", 0, "\"\\ufffd\\ufffd\"");
+TEST_STRING_ASCII(surrogate, "\xed\xa0\x80", 0, "\"\\ufffd\\ufffd\\ufffd\"");
+TEST_STRING_ASCII(truncated, "\xe2\x82", 0, "\"\\ufffd\\ufffd\"");
+
+TEST(jsean_write_string, flags)
+{
+    jsean a;
+
+    ASSERT(jsean_str_flags(NULL) == 0);
+
+    // Strings that are set are scanned when first asked
+    jsean_set_str(&a, "a long string that needs no escaping", 0, NULL);
+    ASSERT(!a.s_known);
+    ASSERT(jsean_str_flags(&a) == JSEAN_STR_ASCII);
+    ASSERT(a.s_known);
+
+    jsean_set_str(&a, "an escape \" after a long run of text", 0, NULL);
+    ASSERT(jsean_str_flags(&a) == (JSEAN_STR_ESCAPE | JSEAN_STR_ASCII));
+
+    jsean_set_str(&a, "\xc3\xa4 and then an escape after a while \t", 0, NULL);
+    ASSERT(jsean_str_flags(&a) == JSEAN_STR_ESCAPE);
+
+    jsean_set_str(&a, "\xc3\xa4", 0, NULL);
+    ASSERT(jsean_str_flags(&a) == 0);
+}
+
+// Known flags decide whether the string is escaped at all
+TEST(jsean_write_string, known_flags)
+{
+    jsean a;
+    char *buf;
+
+    ASSERT(jsean_read(&a, JSEAN_S("[\"plain text that is long enough\", \"a\\tb\", \"\xc3\xa4\"]")) == JSEAN_SUCCESS);
+
+    buf = jsean_write(&a, NULL, NULL);
+    ASSERT(buf != NULL);
+    ASSERT(strcmp(buf, "[\"plain text that is long enough\",\"a\\tb\",\"\xc3\xa4\"]") == 0);
+    ASSERT(jsean_write_size(&a, NULL) == strlen(buf));
+    free(buf);
+
+    buf = jsean_write_ex(&a, NULL, NULL, JSEAN_WRITE_ASCII);
+    ASSERT(buf != NULL);
+    ASSERT(strcmp(buf, "[\"plain text that is long enough\",\"a\\tb\",\"\\u00e4\"]") == 0);
+    free(buf);
+
+    jsean_free(&a);
+}
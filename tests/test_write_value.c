@@ -5,6 +5,7 @@
 //
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -62,3 +63,179 @@ TEST(jsean_write_value, true)
     jsean_free(&a);
     free(buf);
 }
+
+TEST(jsean_write_value, size)
+{
+    const char *indents[] = {NULL, "", "\t", "    "};
+    jsean a, b;
+    size_t len;
+    char *buf;
+
+    ASSERT(jsean_write_size(NULL, NULL) == 0);
+
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\": [1, 2.5, -3e-9], \"key \\\"\\n\\u0001\": [true, false, null, {}, [], \"x\"], \"c\": {\"d\": {\"e\": []}}}")) == JSEAN_SUCCESS);
+
+    for (size_t i = 0; i < sizeof(indents) / sizeof(*indents); i++) {
+        buf = jsean_write(&a, &len, indents[i]);
+        ASSERT(buf != NULL);
+        ASSERT(jsean_write_size(&a, indents[i]) == len);
+        free(buf);
+    }
+
+    jsean_free(&a);
+
+    // Escaping non-ASCII text makes it longer, and invalid bytes as well
+    ASSERT(jsean_read(&a, JSEAN_S("{\"\xc3\xa9\": [\"\xe2\x82\xac\\n\", \"\xf0\x9f\x98\x80\"]}")) == JSEAN_SUCCESS);
+    ASSERT(jsean_set_str(&b, "\xff\xc3x", 0, NULL) == JSEAN_SUCCESS);
+    ASSERT(jsean_arr_push(jsean_obj_at(&a, JSEAN_S("\xc3\xa9")), &b) != NULL);
+
+    for (size_t i = 0; i < sizeof(indents) / sizeof(*indents); i++) {
+        buf = jsean_write_ex(&a, &len, indents[i], JSEAN_WRITE_ASCII);
+        ASSERT(buf != NULL);
+        ASSERT(jsean_write_size_ex(&a, indents[i], JSEAN_WRITE_ASCII) == len);
+        ASSERT(jsean_write_size(&a, indents[i]) < len);
+        free(buf);
+    }
+
+    jsean_free(&a);
+}
+
+TEST(jsean_write_value, to)
+{
+    char buf[LEN], *tmp;
+    jsean a;
+    size_t len;
+
+    ASSERT(jsean_read(&a, JSEAN_S("{\"a\": [1, 2.5, \"\\n\"], \"b\": null}")) == JSEAN_SUCCESS);
+
+    tmp = jsean_write(&a, &len, " ");
+    ASSERT(tmp != NULL);
+
+    ASSERT(jsean_write_to(NULL, buf, LEN, NULL) == 0);
+    ASSERT(jsean_write_to(&a, NULL, LEN, NULL) == 0);
+
+    // Exactly enough room, and one byte too little
+    memset(buf, 0, LEN);
+    ASSERT(jsean_write_to(&a, buf, len, " ") == len);
+    ASSERT(memcmp(buf, tmp, len) == 0);
+    ASSERT(buf[len] == '\0');
+    ASSERT(jsean_write_to(&a, buf, len - 1, " ") == 0);
+    free(tmp);
+    jsean_free(&a);
+
+    // With escapes for the BMP and above U+FFFF, the size is still exact
+    ASSERT(jsean_read(&a, JSEAN_S("{\"\xc3\xa9\": [\"\xe2\x82\xac\", \"\xf0\x9f\x98\x80\"]}")) == JSEAN_SUCCESS);
+    len = jsean_write_size_ex(&a, " ", JSEAN_WRITE_ASCII);
+    ASSERT(len == 45);
+
+    memset(buf, 0, LEN);
+    ASSERT(jsean_write_to_ex(&a, buf, len, " ", JSEAN_WRITE_ASCII) == len);
+    ASSERT(strcmp(buf, "{\n \"\\u00e9\": [\n \"\\u20ac\",\n \"\\ud83d\\ude00\"\n]\n}") == 0);
+    ASSERT(jsean_write_to_ex(&a, buf, len - 1, " ", JSEAN_WRITE_ASCII) == 0);
+
+    jsean_free(&a);
+
+    // Escapes at the end of the buffer, where reserving more room than they
+    // take would fail
+    ASSERT(jsean_read(&a, JSEAN_S("\"\xc3\xa9\"")) == JSEAN_SUCCESS);
+    ASSERT(jsean_write_size_ex(&a, NULL, JSEAN_WRITE_ASCII) == 8);
+    ASSERT(jsean_write_to_ex(&a, buf, 8, NULL, JSEAN_WRITE_ASCII) == 8);
+    ASSERT(memcmp(buf, "\"\\u00e9\"", 8) == 0);
+    ASSERT(jsean_write_to_ex(&a, buf, 7, NULL, JSEAN_WRITE_ASCII) == 0);
+    jsean_free(&a);
+
+    ASSERT(jsean_read(&a, JSEAN_S("\"\xf0\x9f\x98\x80\"")) == JSEAN_SUCCESS);
+    ASSERT(jsean_write_size_ex(&a, NULL, JSEAN_WRITE_ASCII) == 14);
+    ASSERT(jsean_write_to_ex(&a, buf, 14, NULL, JSEAN_WRITE_ASCII) == 14);
+    ASSERT(memcmp(buf, "\"\\ud83d\\ude00\"", 14) == 0);
+    ASSERT(jsean_write_to_ex(&a, buf, 13, NULL, JSEAN_WRITE_ASCII) == 0);
+
+    jsean_free(&a);
+}
+
+// Returns true if the text is the same as written by one thread
+static bool same_parallel(const jsean *json)
+{
+    const char *indents[] = {NULL, "  "};
+    char *expected, *buf;
+    size_t expected_len, len;
+    bool same = true;
+
+    for (size_t i = 0; i < sizeof(indents) / sizeof(*indents); i++) {
+        for (unsigned int threads = 0; threads <= 5; threads++) {
+            expected = jsean_write(json, &expected_len, indents[i]);
+            buf = jsean_write_parallel(json, &len, indents[i], 0, threads);
+
+            if (!expected || !buf || len != expected_len || strcmp(buf, expected) != 0)
+                same = false;
+
+            free(expected);
+            free(buf);
+        }
+    }
+
+    return same;
+}
+
+TEST(jsean_write_value, parallel)
+{
+    jsean arr, obj, key, val;
+    char buf[32];
+
+    ASSERT(jsean_write_parallel(NULL, NULL, NULL, 0, 4) == NULL);
+
+    jsean_set_arr(&arr);
+    ASSERT(same_parallel(&arr));
+
+    for (int i = 0; i < 10000; i++) {
+        switch (i % 4) {
+        case 0:
+            jsean_set_num(&val, i * 0.25);
+            break;
+
+        case 1:
+            ASSERT(jsean_read(&val, JSEAN_S("\"a string with \\\"escapes\\\" in it\"")) == JSEAN_SUCCESS);
+            break;
+
+        case 2:
+            ASSERT(jsean_read(&val, JSEAN_S("{\"a\": [1, null, {}], \"b\": []}")) == JSEAN_SUCCESS);
+            break;
+
+        default:
+            jsean_set_bool(&val, true);
+            break;
+        }
+
+        ASSERT(jsean_arr_push(&arr, &val) != NULL);
+    }
+    ASSERT(same_parallel(&arr));
+
+    // Members of an object, with some of them deleted
+    jsean_set_obj(&obj);
+    for (int i = 0; i < 5000; i++) {
+        sprintf(buf, "key %d", i);
+        ASSERT(jsean_set_str(&key, strdup(buf), 0, free) == JSEAN_SUCCESS);
+        jsean_set_num(&val, i);
+        ASSERT(jsean_obj_set(&obj, &key, &val) != NULL);
+    }
+    for (int i = 0; i < 5000; i += 3) {
+        sprintf(buf, "key %d", i);
+        jsean_set_str(&key, buf, 0, NULL);
+        jsean_obj_del(&obj, &key);
+    }
+    ASSERT(same_parallel(&obj));
+
+    ASSERT(jsean_arr_push(&arr, &obj) != NULL);
+    ASSERT(same_parallel(&arr));
+    jsean_free(&arr);
+
+    // Packed numbers
+    jsean_set_arr(&arr);
+    for (int i = 0; i < 5000; i++) {
+        jsean_set_num(&val, i / 8.0);
+        ASSERT(jsean_arr_push(&arr, &val) != NULL);
+    }
+    ASSERT(jsean_arr_pack(&arr) == JSEAN_SUCCESS);
+    ASSERT(same_parallel(&arr));
+    jsean_free(&arr);
+}